@@ -0,0 +1,183 @@
+//micro benchmarks for the hot paths under the search, run over the bench positions
+//  ds_chess_micro_benchmarks --benchmark_out=micro_benchmarks.json --benchmark_out_format=json
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "bench.h"
+#include "board.h"
+#include "evaluation.h"
+#include "move_generator.h"
+#include "material_table.h"
+#include "pawn_table.h"
+#include "san.h"
+
+static std::vector<Board::Board> load_positions() {
+    std::vector<Board::Board> boards = std::vector<Board::Board>();
+    for (const std::string &fen : Bench::POSITIONS) {
+        boards.push_back(Board::Board(fen));
+    }
+    return boards;
+}
+
+static void BM_ParseFen(benchmark::State &state) {
+    for (auto _ : state) {
+        for (const std::string &fen : Bench::POSITIONS) {
+            Board::Board board = Board::Board(fen);
+            benchmark::DoNotOptimize(board);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * Bench::POSITIONS.size());
+}
+BENCHMARK(BM_ParseFen);
+
+static void BM_SetFen(benchmark::State &state) {
+    Board::Board board = Board::Board();
+    for (auto _ : state) {
+        for (const std::string &fen : Bench::POSITIONS) {
+            benchmark::DoNotOptimize(board.set_fen(fen));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * Bench::POSITIONS.size());
+}
+BENCHMARK(BM_SetFen);
+
+static void BM_ToFen(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    Board::FenBuffer buffer = Board::FenBuffer();
+    for (auto _ : state) {
+        for (Board::Board &board : boards) {
+            benchmark::DoNotOptimize(board.to_fen(&buffer).data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_ToFen);
+
+static void BM_MakeUnmakeMove(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    std::vector<std::vector<Move::Move>> moves = std::vector<std::vector<Move::Move>>();
+    size_t move_count = 0;
+    for (Board::Board &board : boards) {
+        moves.push_back(MoveGenerator::generate_moves(&board));
+        move_count += moves.back().size();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < boards.size(); i++) {
+            for (Move::Move &move : moves[i]) {
+                boards[i].make_move(&move);
+                boards[i].unmake_move(&move);
+            }
+            benchmark::DoNotOptimize(boards[i].key);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * move_count);
+}
+BENCHMARK(BM_MakeUnmakeMove);
+
+static void BM_GenerateMoves(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    for (auto _ : state) {
+        for (Board::Board &board : boards) {
+            std::vector<Move::Move> moves = MoveGenerator::generate_moves(&board);
+            benchmark::DoNotOptimize(moves.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_GenerateMoves);
+
+static void BM_GenerateCaptureMoves(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    for (auto _ : state) {
+        for (Board::Board &board : boards) {
+            std::vector<Move::Move> moves = MoveGenerator::generate_capture_moves(&board);
+            benchmark::DoNotOptimize(moves.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_GenerateCaptureMoves);
+
+static void BM_IsValidMove(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    std::vector<std::vector<Move::Move>> moves = std::vector<std::vector<Move::Move>>();
+    size_t move_count = 0;
+    for (Board::Board &board : boards) {
+        moves.push_back(MoveGenerator::generate_moves(&board));
+        move_count += moves.back().size();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < boards.size(); i++) {
+            for (Move::Move &move : moves[i]) {
+                Board::MoveResult result = boards[i].is_valid_move(&move);
+                benchmark::DoNotOptimize(result);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * move_count);
+}
+BENCHMARK(BM_IsValidMove);
+
+static void BM_ToSan(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    std::vector<std::vector<Move::Move>> moves = std::vector<std::vector<Move::Move>>();
+    size_t move_count = 0;
+    for (Board::Board &board : boards) {
+        moves.push_back(MoveGenerator::generate_moves(&board));
+        move_count += moves.back().size();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < boards.size(); i++) {
+            for (Move::Move &move : moves[i]) {
+                benchmark::DoNotOptimize(SAN::to_san(&boards[i], &move));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * move_count);
+}
+BENCHMARK(BM_ToSan);
+
+static void BM_FromSan(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    std::vector<std::vector<std::string>> sans = std::vector<std::vector<std::string>>();
+    size_t move_count = 0;
+    for (Board::Board &board : boards) {
+        sans.push_back(std::vector<std::string>());
+        for (Move::Move &move : MoveGenerator::generate_moves(&board)) {
+            sans.back().push_back(SAN::to_san(&board, &move));
+        }
+        move_count += sans.back().size();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < boards.size(); i++) {
+            for (std::string &san : sans[i]) {
+                benchmark::DoNotOptimize(SAN::from_san(&boards[i], san));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * move_count);
+}
+BENCHMARK(BM_FromSan);
+
+static void BM_EvaluateBoard(benchmark::State &state) {
+    std::vector<Board::Board> boards = load_positions();
+    //the same few structures over and over, so this measures the evaluation with the pawn terms cached
+    PawnTable::PawnTable pawn_table = PawnTable::PawnTable(PawnTable::DEFAULT_SIZE);
+    MaterialTable::MaterialTable material_table = MaterialTable::MaterialTable(MaterialTable::DEFAULT_SIZE);
+    for (auto _ : state) {
+        for (Board::Board &board : boards) {
+            benchmark::DoNotOptimize(Evaluation::evaluate_board(&board, &pawn_table, &material_table));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_EvaluateBoard);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,20 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bench {
+    //deep enough to exercise the pruning and extensions, short enough to run in well under a minute
+    const int32_t DEFAULT_DEPTH = 5;
+
+    //fixed set of openings, middlegames, endgames, mates and stalemates, searched in this order
+    extern const std::vector<std::string> POSITIONS;
+
+    //searches every position to depth with a fresh transposition table and prints the total nodes,
+    //time and nodes per second; the node count only changes when the search itself does
+    void bench(int32_t depth);
+};
+
+#endif
@@ -0,0 +1,508 @@
+#include "bitbase.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Bitbase {
+    //a weak king to move that can take an undefended piece (or is stalemated) is never lost,
+    //its move counter starts here so it never reaches 0
+    const uint8_t ESCAPE = 255;
+    //frontiers smaller than this are expanded on the calling thread
+    const size_t MIN_PARALLEL_SIZE = 4096;
+
+    //the stronger side is always white (so a pawn moves up the board) and the index is
+    //((strong king * 64 + weak king) * 64 + first piece) * 64 + second piece, with the board mirrored
+    //so the stronger king is on files a-d, and without pawns on ranks 1-4 as well
+    struct Position {
+        int32_t strong_king;
+        int32_t weak_king;
+        std::array<int32_t, 2> pieces;
+    };
+
+    struct Table {
+        std::vector<Move::PieceType> piece_types;
+        bool has_pawns = false;
+        //positions for each side to move
+        size_t size = 0;
+        //whether the stronger side wins, [0] with it to move and [1] with the weaker side to move
+        std::array<std::vector<uint64_t>, 2> wins;
+        //set once the table is generated, probes of the endgame find nothing until then
+        std::atomic<bool> ready = false;
+    };
+
+    std::array<Table, ENDGAME_COUNT> tables;
+    std::once_flag generated;
+    std::atomic<bool> cancelled = false;
+
+    enum Alignment : uint8_t {
+        NotAligned,
+        Diagonal,
+        Straight
+    };
+
+    uint64_t KING_ATTACKS[64];
+    uint64_t KNIGHT_ATTACKS[64];
+    //the squares strictly between two squares on a line, so a slider's attack on one square is a single lookup
+    uint64_t BETWEEN[64][64];
+    Alignment ALIGNMENT[64][64];
+};
+
+static uint64_t square_bit(int32_t square) {
+    return 1ULL << square;
+}
+
+static int32_t rank_of(int32_t square) {
+    return square >> 3;
+}
+
+static int32_t file_of(int32_t square) {
+    return square & 7;
+}
+
+//the first 4 are diagonal
+const int32_t DIRECTIONS[8][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+static void init_attacks() {
+    using namespace Bitbase;
+
+    const int32_t KING_STEPS[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    const int32_t KNIGHT_STEPS[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+    for (int32_t s = 0; s < 64; s++) {
+        KING_ATTACKS[s] = 0;
+        KNIGHT_ATTACKS[s] = 0;
+        for (size_t i = 0; i < 8; i++) {
+            int32_t rank = rank_of(s) + KING_STEPS[i][0];
+            int32_t file = file_of(s) + KING_STEPS[i][1];
+            if (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+                KING_ATTACKS[s] |= square_bit(rank * 8 + file);
+            }
+            rank = rank_of(s) + KNIGHT_STEPS[i][0];
+            file = file_of(s) + KNIGHT_STEPS[i][1];
+            if (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+                KNIGHT_ATTACKS[s] |= square_bit(rank * 8 + file);
+            }
+        }
+
+        for (size_t i = 0; i < 8; i++) {
+            uint64_t between = 0;
+            int32_t rank = rank_of(s) + DIRECTIONS[i][0];
+            int32_t file = file_of(s) + DIRECTIONS[i][1];
+            while (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+                BETWEEN[s][rank * 8 + file] = between;
+                ALIGNMENT[s][rank * 8 + file] = i < 4 ? Diagonal : Straight;
+                between |= square_bit(rank * 8 + file);
+                rank += DIRECTIONS[i][0];
+                file += DIRECTIONS[i][1];
+            }
+        }
+    }
+}
+
+//squares reached along the rays, stopping at the first occupied square
+static uint64_t slider_attacks(int32_t square, uint64_t occupancy, bool diagonal, bool straight) {
+    uint64_t attacks = 0;
+    for (size_t i = diagonal ? 0 : 4; i < (straight ? 8 : 4); i++) {
+        int32_t rank = rank_of(square) + DIRECTIONS[i][0];
+        int32_t file = file_of(square) + DIRECTIONS[i][1];
+        while (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+            attacks |= square_bit(rank * 8 + file);
+            if (occupancy & square_bit(rank * 8 + file)) {
+                break;
+            }
+            rank += DIRECTIONS[i][0];
+            file += DIRECTIONS[i][1];
+        }
+    }
+    return attacks;
+}
+
+//a position and its mirror images have the same result so only one of them is stored. None of them
+//is its own mirror image, which keeps the count of the weaker side's moves into won positions exact
+static size_t encode(Bitbase::Table *table, Bitbase::Position *position) {
+    int32_t flip = file_of(position->strong_king) > 3 ? 7 : 0;
+    if (!table->has_pawns && rank_of(position->strong_king) > 3) {
+        flip ^= 56;
+    }
+    int32_t strong_king = position->strong_king ^ flip;
+    size_t index = (rank_of(strong_king) * 4 + file_of(strong_king)) * 64 + (position->weak_king ^ flip);
+    for (size_t i = 0; i < table->piece_types.size(); i++) {
+        index = index * 64 + (position->pieces[i] ^ flip);
+    }
+    return index;
+}
+
+static Bitbase::Position decode(Bitbase::Table *table, size_t index) {
+    Bitbase::Position position = Bitbase::Position();
+    for (size_t i = table->piece_types.size(); i-- > 0;) {
+        position.pieces[i] = (int32_t) (index % 64);
+        index /= 64;
+    }
+    position.weak_king = (int32_t) (index % 64);
+    index /= 64;
+    position.strong_king = (int32_t) ((index / 4) * 8 + index % 4);
+    return position;
+}
+
+static uint64_t occupancy_of(Bitbase::Table *table, Bitbase::Position *position) {
+    uint64_t occupancy = square_bit(position->strong_king) | square_bit(position->weak_king);
+    for (size_t i = 0; i < table->piece_types.size(); i++) {
+        occupancy |= square_bit(position->pieces[i]);
+    }
+    return occupancy;
+}
+
+//whether the stronger side attacks square, without the piece captured on skip
+static bool is_attacked(
+    Bitbase::Table *table, Bitbase::Position *position, int32_t square, uint64_t occupancy, std::optional<size_t> skip
+) {
+    using namespace Bitbase;
+
+    if (KING_ATTACKS[position->strong_king] & square_bit(square)) {
+        return true;
+    }
+    for (size_t i = 0; i < table->piece_types.size(); i++) {
+        int32_t from = position->pieces[i];
+        if (skip == i) {
+            continue;
+        }
+        bool attacks = false;
+        switch (table->piece_types[i]) {
+            case Move::PieceType::Pawn:
+                attacks = (file_of(from) > 0 && from + 7 == square) || (file_of(from) < 7 && from + 9 == square);
+                break;
+            case Move::PieceType::Knight:
+                attacks = KNIGHT_ATTACKS[from] & square_bit(square);
+                break;
+            case Move::PieceType::Bishop:
+                attacks = ALIGNMENT[from][square] == Diagonal && !(BETWEEN[from][square] & occupancy);
+                break;
+            case Move::PieceType::Rook:
+                attacks = ALIGNMENT[from][square] == Straight && !(BETWEEN[from][square] & occupancy);
+                break;
+            case Move::PieceType::Queen:
+                attacks = ALIGNMENT[from][square] != NotAligned && !(BETWEEN[from][square] & occupancy);
+                break;
+            default:
+                break;
+        }
+        if (attacks) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//every square different, kings apart and pawns off the first and last ranks
+static bool is_valid(Bitbase::Table *table, Bitbase::Position *position) {
+    uint64_t occupancy = occupancy_of(table, position);
+    if (std::popcount(occupancy) != (int32_t) table->piece_types.size() + 2) {
+        return false;
+    }
+    if (Bitbase::KING_ATTACKS[position->strong_king] & square_bit(position->weak_king)) {
+        return false;
+    }
+    for (size_t i = 0; i < table->piece_types.size(); i++) {
+        int32_t rank = rank_of(position->pieces[i]);
+        if (table->piece_types[i] == Move::PieceType::Pawn && (rank == 0 || rank == 7)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_legal_strong_to_move(Bitbase::Table *table, Bitbase::Position *position) {
+    return is_valid(table, position)
+        && !is_attacked(table, position, position->weak_king, occupancy_of(table, position), std::nullopt);
+}
+
+static bool is_lost_for_weak(Bitbase::Table *table, Bitbase::Position *position) {
+    size_t index = encode(table, position);
+    return (table->wins[1][index / 64] >> (index % 64)) & 1;
+}
+
+//runs work(begin, end, found) over [0, size) on threads, collecting what every thread found
+static std::vector<size_t> parallel_for(
+    size_t size,
+    size_t threads,
+    const std::function<void(size_t, size_t, std::vector<size_t> *)> &work
+) {
+    threads = size < Bitbase::MIN_PARALLEL_SIZE ? 1 : std::max<size_t>(threads, 1);
+    std::vector<std::vector<size_t>> found = std::vector<std::vector<size_t>>(threads);
+    std::vector<std::thread> workers = std::vector<std::thread>();
+    size_t chunk = (size + threads - 1) / threads;
+    for (size_t i = 1; i < threads; i++) {
+        workers.push_back(std::thread(work, std::min(size, i * chunk), std::min(size, (i + 1) * chunk), &found[i]));
+    }
+    work(0, std::min(size, chunk), &found[0]);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    for (size_t i = 1; i < threads; i++) {
+        found[0].insert(found[0].end(), found[i].begin(), found[i].end());
+    }
+    return found[0];
+}
+
+//retrograde analysis: the weaker side loses once every one of its moves leads to a win for the stronger side,
+//which wins as soon as one of its moves leads to a loss for the weaker side. Starting from the mates (and for
+//KPK the winning promotions) the results are spread backwards one ply at a time, each position only
+//looking at its predecessors once it's decided
+static void generate(Bitbase::Table *table, size_t threads) {
+    using namespace Bitbase;
+
+    //moves left for the weaker side to move before it's lost
+    std::vector<std::atomic<uint8_t>> counters = std::vector<std::atomic<uint8_t>>(table->size);
+    //a bit per position, small enough to stay in the cache
+    std::vector<std::atomic<uint64_t>> strong_wins = std::vector<std::atomic<uint64_t>>((table->size + 63) / 64);
+
+    std::vector<size_t> lost = parallel_for(table->size, threads, [&](size_t begin, size_t end, std::vector<size_t> *found) {
+        //a cancel is noticed partway through a pass, some of them take a good part of a second
+        for (size_t index = begin; index < end && !cancelled.load(std::memory_order_relaxed); index++) {
+            Position position = decode(table, index);
+            if (!is_valid(table, &position)) {
+                counters[index] = ESCAPE;
+                continue;
+            }
+            uint64_t occupancy = occupancy_of(table, &position);
+            bool in_check = is_attacked(table, &position, position.weak_king, occupancy, std::nullopt);
+            //the king doesn't block the rays it moves along
+            uint64_t without_king = occupancy ^ square_bit(position.weak_king);
+            uint8_t moves = 0;
+            bool escape = false;
+            uint64_t targets = KING_ATTACKS[position.weak_king] & ~KING_ATTACKS[position.strong_king];
+            for (int32_t target = 0; target < 64; target++) {
+                if (!(targets & square_bit(target))) {
+                    continue;
+                }
+                std::optional<size_t> captured = std::nullopt;
+                for (size_t i = 0; i < table->piece_types.size(); i++) {
+                    if (position.pieces[i] == target) {
+                        captured = i;
+                    }
+                }
+                if (is_attacked(table, &position, target, without_king, captured)) {
+                    continue;
+                }
+                if (captured.has_value()) {
+                    //a bare king (or king against a lone minor piece) can't lose
+                    escape = true;
+                } else {
+                    moves += 1;
+                }
+            }
+            if (escape || (moves == 0 && !in_check)) {
+                counters[index] = ESCAPE;
+            } else {
+                counters[index] = moves;
+                if (moves == 0) {
+                    found->push_back(index);
+                }
+            }
+        }
+    });
+
+    //a pawn promoting into a won KQK or KRK position wins straight away
+    std::vector<size_t> won = std::vector<size_t>();
+    size_t pawn = std::find(table->piece_types.begin(), table->piece_types.end(), Move::PieceType::Pawn)
+        - table->piece_types.begin();
+    if (pawn < table->piece_types.size()) {
+        won = parallel_for(table->size, threads, [&](size_t begin, size_t end, std::vector<size_t> *found) {
+            for (size_t index = begin; index < end && !cancelled.load(std::memory_order_relaxed); index++) {
+                Position position = decode(table, index);
+                if (rank_of(position.pieces[pawn]) != 6 || !is_legal_strong_to_move(table, &position)) {
+                    continue;
+                }
+                Position promoted = position;
+                promoted.pieces[pawn] += 8;
+                if (occupancy_of(table, &position) & square_bit(promoted.pieces[pawn])) {
+                    continue;
+                }
+                if (is_lost_for_weak(&tables[KQK], &promoted) || is_lost_for_weak(&tables[KRK], &promoted)) {
+                    strong_wins[index / 64].fetch_or(1ULL << (index % 64));
+                    found->push_back(index);
+                }
+            }
+        });
+    }
+
+    while ((!lost.empty() || !won.empty()) && !cancelled.load(std::memory_order_relaxed)) {
+        //the stronger side's moves into the lost positions, undone
+        std::vector<size_t> newly_won = parallel_for(lost.size(), threads, [&](size_t begin, size_t end, std::vector<size_t> *found) {
+            for (size_t i = begin; i < end && !cancelled.load(std::memory_order_relaxed); i++) {
+                Position position = decode(table, lost[i]);
+                uint64_t occupancy = occupancy_of(table, &position);
+                for (size_t piece = 0; piece <= table->piece_types.size(); piece++) {
+                    int32_t *square = piece == table->piece_types.size() ? &position.strong_king : &position.pieces[piece];
+                    int32_t from = *square;
+                    uint64_t origins;
+                    if (piece == table->piece_types.size()) {
+                        origins = KING_ATTACKS[from] & ~KING_ATTACKS[position.weak_king];
+                    } else if (table->piece_types[piece] == Move::PieceType::Pawn) {
+                        origins = 0;
+                        if (rank_of(from) >= 2 && !(occupancy & square_bit(from - 8))) {
+                            origins |= square_bit(from - 8);
+                            if (rank_of(from) == 3 && !(occupancy & square_bit(from - 16))) {
+                                origins |= square_bit(from - 16);
+                            }
+                        }
+                    } else if (table->piece_types[piece] == Move::PieceType::Knight) {
+                        origins = KNIGHT_ATTACKS[from];
+                    } else {
+                        origins = slider_attacks(
+                            from,
+                            occupancy,
+                            table->piece_types[piece] != Move::PieceType::Rook,
+                            table->piece_types[piece] != Move::PieceType::Bishop
+                        );
+                    }
+                    origins &= ~occupancy;
+                    for (; origins != 0; origins &= origins - 1) {
+                        int32_t origin = std::countr_zero(origins);
+                        *square = origin;
+                        //the origins are empty and away from the weaker king, so only a check makes it illegal
+                        uint64_t before = occupancy ^ square_bit(from) ^ square_bit(origin);
+                        if (!is_attacked(table, &position, position.weak_king, before, std::nullopt)) {
+                            size_t predecessor = encode(table, &position);
+                            std::atomic<uint64_t> *word = &strong_wins[predecessor / 64];
+                            uint64_t bit = 1ULL << (predecessor % 64);
+                            //most predecessors are already won, which a plain read tells without locking the word
+                            if (!(word->load(std::memory_order_relaxed) & bit) && !(word->fetch_or(bit) & bit)) {
+                                found->push_back(predecessor);
+                            }
+                        }
+                    }
+                    *square = from;
+                }
+            }
+        });
+        won.insert(won.end(), newly_won.begin(), newly_won.end());
+
+        //the weaker king's moves into the won positions, undone
+        lost = parallel_for(won.size(), threads, [&](size_t begin, size_t end, std::vector<size_t> *found) {
+            for (size_t i = begin; i < end && !cancelled.load(std::memory_order_relaxed); i++) {
+                Position position = decode(table, won[i]);
+                uint64_t occupancy = occupancy_of(table, &position);
+                int32_t from = position.weak_king;
+                uint64_t origins = KING_ATTACKS[from] & ~KING_ATTACKS[position.strong_king] & ~occupancy;
+                for (; origins != 0; origins &= origins - 1) {
+                    position.weak_king = std::countr_zero(origins);
+                    size_t predecessor = encode(table, &position);
+                    if (counters[predecessor].fetch_sub(1) == 1) {
+                        found->push_back(predecessor);
+                    }
+                }
+            }
+        });
+        won.clear();
+    }
+
+    table->wins[0] = std::vector<uint64_t>(strong_wins.begin(), strong_wins.end());
+    table->wins[1].assign((table->size + 63) / 64, 0);
+    for (size_t index = 0; index < table->size; index++) {
+        if (counters[index] == 0) {
+            table->wins[1][index / 64] |= 1ULL << (index % 64);
+        }
+    }
+}
+
+void Bitbase::init(size_t threads) {
+    //a call made while another one is generating waits for it to finish
+    std::call_once(generated, [threads]() {
+        init_attacks();
+
+        tables[KPK].piece_types = {Move::PieceType::Pawn};
+        tables[KRK].piece_types = {Move::PieceType::Rook};
+        tables[KQK].piece_types = {Move::PieceType::Queen};
+        tables[KBNK].piece_types = {Move::PieceType::Bishop, Move::PieceType::Knight};
+        for (Table &table : tables) {
+            table.has_pawns = table.piece_types[0] == Move::PieceType::Pawn;
+            table.size = (table.has_pawns ? 32 : 16) * 64;
+            for (size_t i = 0; i < table.piece_types.size(); i++) {
+                table.size *= 64;
+            }
+        }
+
+        //KPK promotes into KQK and KRK, and KBNK is by far the biggest so it comes last
+        for (Endgame endgame : {KRK, KQK, KPK, KBNK}) {
+            generate(&tables[endgame], threads);
+            //a cancelled table is only partly analysed
+            if (cancelled.load(std::memory_order_relaxed)) {
+                break;
+            }
+            tables[endgame].ready.store(true, std::memory_order_release);
+        }
+    });
+}
+
+void Bitbase::cancel() {
+    cancelled.store(true, std::memory_order_relaxed);
+}
+
+std::optional<Bitbase::Probe> Bitbase::probe(Board::Board *board) {
+    std::array<std::optional<Move::Index>, 2> kings = {std::nullopt, std::nullopt};
+    std::array<Move::Index, 2> pieces = {0, 0};
+    std::array<Move::PieceType, 2> piece_types = {Move::PieceType::Pawn, Move::PieceType::Pawn};
+    std::optional<Move::Color> strong_side = std::nullopt;
+    size_t piece_count = 0;
+    for (Move::Index i = 0; i < 64; i++) {
+        if (!board->board[i].has_value()) {
+            continue;
+        }
+        Move::Piece piece = board->board[i].value();
+        if (piece.piece_type == Move::PieceType::King) {
+            kings[piece.color == Move::Color::White ? 0 : 1] = i;
+            continue;
+        }
+        if (piece_count == 2 || (strong_side.has_value() && strong_side.value() != piece.color)) {
+            return std::nullopt;
+        }
+        strong_side = piece.color;
+        pieces[piece_count] = i;
+        piece_types[piece_count++] = piece.piece_type;
+    }
+    if (!strong_side.has_value() || !kings[0].has_value() || !kings[1].has_value()) {
+        return std::nullopt;
+    }
+
+    Endgame endgame;
+    if (piece_count == 1 && piece_types[0] == Move::PieceType::Pawn) {
+        endgame = KPK;
+    } else if (piece_count == 1 && piece_types[0] == Move::PieceType::Rook) {
+        endgame = KRK;
+    } else if (piece_count == 1 && piece_types[0] == Move::PieceType::Queen) {
+        endgame = KQK;
+    } else if (piece_count == 2 && piece_types[0] == Move::PieceType::Bishop && piece_types[1] == Move::PieceType::Knight) {
+        endgame = KBNK;
+    } else if (piece_count == 2 && piece_types[0] == Move::PieceType::Knight && piece_types[1] == Move::PieceType::Bishop) {
+        endgame = KBNK;
+        std::swap(pieces[0], pieces[1]);
+    } else {
+        return std::nullopt;
+    }
+
+    //the tables have the stronger side as white
+    bool white_strong = strong_side.value() == Move::Color::White;
+    int32_t flip = white_strong ? 0 : 56;
+    Move::Index strong_king = kings[white_strong ? 0 : 1].value();
+    Move::Index weak_king = kings[white_strong ? 1 : 0].value();
+    Position position = Position();
+    position.strong_king = (int32_t) strong_king ^ flip;
+    position.weak_king = (int32_t) weak_king ^ flip;
+    for (size_t i = 0; i < piece_count; i++) {
+        position.pieces[i] = (int32_t) pieces[i] ^ flip;
+    }
+
+    Table *table = &tables[endgame];
+    if (!table->ready.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+    size_t index = encode(table, &position);
+    size_t side = board->current_player == strong_side.value() ? 0 : 1;
+    bool win = (table->wins[side][index / 64] >> (index % 64)) & 1;
+    return Probe {endgame, strong_side.value(), win, strong_king, weak_king, pieces};
+}
@@ -0,0 +1,44 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "board.h"
+#include "move.h"
+
+//win/draw bitbases of the endgames where one side has nothing but its king: KPK, KRK, KQK and KBNK.
+//They're generated by retrograde analysis rather than read from files, one bit per position telling
+//whether the stronger side wins with the best play
+namespace Bitbase {
+    enum Endgame {
+        KPK,
+        KRK,
+        KQK,
+        KBNK
+    };
+    const size_t ENDGAME_COUNT = 4;
+
+    //what a position of one of the endgames is, squares are the board's own
+    struct Probe {
+        Endgame endgame;
+        Move::Color strong_side;
+        bool win;
+        Move::Index strong_king;
+        Move::Index weak_king;
+        //the stronger side's other pieces: the pawn, rook or queen, or the bishop and then the knight
+        std::array<Move::Index, 2> pieces;
+    };
+
+    //generates every bitbase with the work split over threads, taking a few seconds for KBNK. Only the
+    //first call does anything, later calls return once it's done
+    void init(size_t threads);
+    //has a running init return as soon as its threads notice, leaving the endgame it was on (and the ones after it)
+    //without a bitbase for good
+    void cancel();
+    //nullopt unless the position is one of the endgames and its bitbase is generated
+    std::optional<Probe> probe(Board::Board *board);
+};
+
+#endif
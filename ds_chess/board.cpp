@@ -8,10 +8,15 @@
 #include <optional>
 
 #include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
 
 #include "move.h"
+#include "zobrist.h"
 
-Board::Board::Board (std::string fen) :
+Board::Board::Board() :
     board(std::array<std::optional<Move::Piece>, 64>()),
     current_player(Move::Color::White),
     can_white_kingside_castle(false),
@@ -20,167 +25,294 @@ Board::Board::Board (std::string fen) :
     can_black_queenside_castle(false),
     en_passant(std::nullopt),
     moves_since_last_pawn_move_or_capture(0),
-    num_moves(0)
+    num_moves(1),
+    key(0),
+    pawn_key(0),
+    material_key(0),
+    key_history(std::vector<uint64_t>())
 {
-    //handle pieces on the board
-    Move::Index index = 63;
+    this->key = Zobrist::compute_key(this);
+}
+
+Board::Board::Board (std::string_view fen) : Board() {
+    FenResult result = this->set_fen(fen);
+    if (std::holds_alternative<FenError>(result)) {
+        throw std::invalid_argument("invalid fen string, error " + std::to_string(std::get<FenError>(result)));
+    }
+}
 
+static std::optional<Move::Piece> piece_from_fen_char(char c) {
+    Move::Color color = isupper(c) ? Move::Color::White : Move::Color::Black;
+    switch (tolower(c)) {
+    case 'p': return Move::Piece(color, Move::PieceType::Pawn);
+    case 'n': return Move::Piece(color, Move::PieceType::Knight);
+    case 'b': return Move::Piece(color, Move::PieceType::Bishop);
+    case 'r': return Move::Piece(color, Move::PieceType::Rook);
+    case 'q': return Move::Piece(color, Move::PieceType::Queen);
+    case 'k': return Move::Piece(color, Move::PieceType::King);
+    default: return std::nullopt;
+    }
+}
+
+static char piece_to_fen_char(Move::Piece piece) {
+    char c = "pnbrqk"[piece.piece_type];
+    return piece.color == Move::Color::White ? (char) toupper(c) : c;
+}
+
+//reads the unsigned number at fen[*i], moving i past it
+static std::optional<size_t> parse_fen_number(std::string_view fen, size_t *i) {
+    size_t value = 0;
+    auto [end, error] = std::from_chars(fen.data() + *i, fen.data() + fen.size(), value);
+    if (error != std::errc() || (end != fen.data() + fen.size() && *end != ' ')) {
+        return std::nullopt;
+    }
+    *i = end - fen.data();
+    return value;
+}
+
+Board::FenResult Board::Board::set_fen(std::string_view fen) {
+    //everything is parsed into locals first so that a bad fen leaves the board as it was
+    std::array<std::optional<Move::Piece>, 64> pieces = std::array<std::optional<Move::Piece>, 64>();
     size_t i = 0;
-    while (index < 64) {
-        switch (fen[i]) {
-        case 'P':
-            this->board[index] = Move::Piece(Move::Color::White, Move::PieceType::Pawn);
-            index -= 1;
-            break;
-        case 'p':
-            this->board[index] = Move::Piece(Move::Color::Black, Move::PieceType::Pawn);
-            index -= 1;
-            break;
-        case 'N':
-            this->board[index] = Move::Piece(Move::Color::White, Move::PieceType::Knight);
-            index -= 1;
-            break;
-        case 'n':
-            this->board[index] = Move::Piece(Move::Color::Black, Move::PieceType::Knight);
-            index -= 1;
-            break;
-        case 'B':
-            this->board[index] = Move::Piece(Move::Color::White, Move::PieceType::Bishop);
-            index -= 1;
-            break;
-        case 'b':
-            this->board[index] = Move::Piece(Move::Color::Black, Move::PieceType::Bishop);
-            index -= 1;
-            break;
-        case 'R':
-            this->board[index] = Move::Piece(Move::Color::White, Move::PieceType::Rook);
-            index -= 1;
-            break;
-        case 'r':
-            this->board[index] = Move::Piece(Move::Color::Black, Move::PieceType::Rook);
-            index -= 1;
-            break;
-        case 'Q':
-            this->board[index] = Move::Piece(Move::Color::White, Move::PieceType::Queen);
-            index -= 1;
-            break;
-        case 'q':
-            this->board[index] = Move::Piece(Move::Color::Black, Move::PieceType::Queen);
-            index -= 1;
-            break;
-        case 'K':
-            this->board[index] = Move::Piece(Move::Color::White, Move::PieceType::King);
-            index -= 1;
-            break;
-        case 'k':
-            this->board[index] = Move::Piece(Move::Color::Black, Move::PieceType::King);
-            index -= 1;
-            break;
-        case '/':
+    while (i < fen.size() && fen[i] == ' ') {
+        i++;
+    }
+
+    //piece placement from a8 to h8, down to a1 to h1
+    size_t rank = 7;
+    size_t file = 0;
+    size_t kings[2] = {0, 0};
+    while (true) {
+        if (i >= fen.size()) {
+            return FenResult(FenError::InvalidPiecePlacement);
+        }
+        char c = fen[i++];
+        if (c == ' ') {
+            if (rank != 0 || file != 8) {
+                return FenResult(FenError::InvalidPiecePlacement);
+            }
             break;
-        default:
-            if (isdigit(fen[i])) {
-                if (fen[i] >= '1' && fen[i] <= '8') {
-                    index -= fen[i] - '0';
-                    i++;
-                    continue;
-                }
+        } else if (c == '/') {
+            if (rank == 0 || file != 8) {
+                return FenResult(FenError::InvalidPiecePlacement);
             }
-            throw std::invalid_argument("Unexpected value in fen string: " + std::to_string(fen[i]) + " at " + std::to_string(i));
+            rank -= 1;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) {
+                return FenResult(FenError::InvalidPiecePlacement);
+            }
+        } else {
+            std::optional<Move::Piece> piece = piece_from_fen_char(c);
+            if (!piece.has_value() || file >= 8) {
+                return FenResult(FenError::InvalidPiecePlacement);
+            }
+            if (piece.value().piece_type == Move::PieceType::King) {
+                kings[piece.value().color] += 1;
+            }
+            pieces[Move::Move::coord_to_index(rank, file)] = piece;
+            file += 1;
         }
-        i++;
+    }
+    if (kings[Move::Color::White] != 1 || kings[Move::Color::Black] != 1) {
+        return FenResult(FenError::InvalidKings);
     }
 
-    //account for space
-    i++;
+    //side to move
+    Move::Color player;
+    if (i + 1 < fen.size() && fen[i] == 'w' && fen[i + 1] == ' ') {
+        player = Move::Color::White;
+    } else if (i + 1 < fen.size() && fen[i] == 'b' && fen[i + 1] == ' ') {
+        player = Move::Color::Black;
+    } else {
+        return FenResult(FenError::InvalidSideToMove);
+    }
+    i += 2;
 
-    //handle whose turn it is
-    switch (fen[i]) {
-    case 'w':
-        this->current_player = Move::Color::White;
-        i++;
-        break;
-    case 'b':
-        this->current_player = Move::Color::Black;
+    //castling rights, rights whose king or rook isn't on its starting square are dropped
+    bool castling[4] = {false, false, false, false};
+    if (i < fen.size() && fen[i] == '-') {
         i++;
-        break;
-    default:
-        throw std::invalid_argument("Unexpected value in fen string: " + std::to_string(i) + " " + fen[i] + " " + fen[i - 1] + "\\");
+    } else {
+        while (i < fen.size() && fen[i] != ' ') {
+            size_t right;
+            switch (fen[i]) {
+            case 'K': right = 0; break;
+            case 'Q': right = 1; break;
+            case 'k': right = 2; break;
+            case 'q': right = 3; break;
+            default: return FenResult(FenError::InvalidCastlingRights);
+            }
+            if (castling[right]) {
+                return FenResult(FenError::InvalidCastlingRights);
+            }
+            castling[right] = true;
+            i++;
+        }
+    }
+    if (i >= fen.size() || fen[i] != ' ') {
+        return FenResult(FenError::InvalidCastlingRights);
     }
-
-    //acount for space
     i++;
+    Move::Piece white_king = Move::Piece(Move::Color::White, Move::PieceType::King);
+    Move::Piece white_rook = Move::Piece(Move::Color::White, Move::PieceType::Rook);
+    Move::Piece black_king = Move::Piece(Move::Color::Black, Move::PieceType::King);
+    Move::Piece black_rook = Move::Piece(Move::Color::Black, Move::PieceType::Rook);
+    castling[0] = castling[0] && pieces[DEFAULT_WHITE_KING_INDEX] == white_king
+        && pieces[DEFAULT_WHITE_KINGSIDE_ROOK_INDEX] == white_rook;
+    castling[1] = castling[1] && pieces[DEFAULT_WHITE_KING_INDEX] == white_king
+        && pieces[DEFAULT_WHITE_QUEENSIDE_ROOK_INDEX] == white_rook;
+    castling[2] = castling[2] && pieces[DEFAULT_BLACK_KING_INDEX] == black_king
+        && pieces[DEFAULT_BLACK_KINGSIDE_ROOK_INDEX] == black_rook;
+    castling[3] = castling[3] && pieces[DEFAULT_BLACK_KING_INDEX] == black_king
+        && pieces[DEFAULT_BLACK_QUEENSIDE_ROOK_INDEX] == black_rook;
+
+    //en passant square, which has to be behind a pawn that just moved two squares
+    std::optional<size_t> en_passant = std::nullopt;
+    if (i < fen.size() && fen[i] == '-') {
+        i++;
+    } else {
+        if (i + 1 >= fen.size() || fen[i] < 'a' || fen[i] > 'h') {
+            return FenResult(FenError::InvalidEnPassant);
+        }
+        size_t en_passant_file = fen[i] - 'a';
+        size_t en_passant_rank = fen[i + 1] - '1';
+        if (en_passant_rank != (player == Move::Color::White ? 5 : 2)) {
+            return FenResult(FenError::InvalidEnPassant);
+        }
+        //the pawn is one rank past the square towards the side to move, and the square it came from is empty
+        size_t pawn_rank = player == Move::Color::White ? 4 : 3;
+        size_t origin_rank = player == Move::Color::White ? 6 : 1;
+        Move::Piece pushed_pawn = Move::Piece(Move::swap(player), Move::PieceType::Pawn);
+        if (
+            pieces[Move::Move::coord_to_index(pawn_rank, en_passant_file)] != pushed_pawn
+            || pieces[Move::Move::coord_to_index(en_passant_rank, en_passant_file)].has_value()
+            || pieces[Move::Move::coord_to_index(origin_rank, en_passant_file)].has_value()
+        ) {
+            return FenResult(FenError::InvalidEnPassant);
+        }
+        en_passant = Move::Move::coord_to_index(en_passant_rank, en_passant_file);
+        i += 2;
+    }
+    if (i < fen.size() && fen[i] != ' ') {
+        return FenResult(FenError::InvalidEnPassant);
+    }
 
-    //handle castling
-    while(true) {
-        switch (fen[i]) {
-        case 'K':
-            this->can_white_kingside_castle = true;
-            i++;
-            break;
-        case 'Q':
-            this->can_white_queenside_castle = true;
-            i++;
-            break;
-        case 'k':
-            this->can_black_kingside_castle = true;
-            i++;
-            break;
-        case 'q':
-            this->can_black_queenside_castle = true;
+    //the move counters are optional, as in epd
+    size_t halfmove_clock = 0;
+    size_t fullmove_number = 1;
+    while (i < fen.size() && fen[i] == ' ') {
+        i++;
+    }
+    if (i < fen.size()) {
+        std::optional<size_t> number = parse_fen_number(fen, &i);
+        if (!number.has_value()) {
+            return FenResult(FenError::InvalidHalfmoveClock);
+        }
+        halfmove_clock = number.value();
+        while (i < fen.size() && fen[i] == ' ') {
             i++;
-            break;
-        case '-':
+        }
+        if (i < fen.size()) {
+            number = parse_fen_number(fen, &i);
+            if (!number.has_value()) {
+                return FenResult(FenError::InvalidFullmoveNumber);
+            }
+            fullmove_number = std::max<size_t>(1, number.value());
+        }
+        while (i < fen.size() && fen[i] == ' ') {
             i++;
-            goto exit_castling_loop;
-        case ' ':
-            goto exit_castling_loop;
+        }
+        if (i < fen.size()) {
+            return FenResult(FenError::UnexpectedCharacters);
         }
     }
 
-    exit_castling_loop: ;
-
-    //acount for space
-    i++;
+    this->board = pieces;
+    this->current_player = player;
+    this->can_white_kingside_castle = castling[0];
+    this->can_white_queenside_castle = castling[1];
+    this->can_black_kingside_castle = castling[2];
+    this->can_black_queenside_castle = castling[3];
+    this->en_passant = en_passant;
+    this->moves_since_last_pawn_move_or_capture = halfmove_clock;
+    this->num_moves = fullmove_number;
+    //clear keeps the capacity, so reusing a board doesn't allocate
+    this->key_history.clear();
+    this->key = Zobrist::compute_key(this);
+    this->pawn_key = Zobrist::compute_pawn_key(this);
+    this->material_key = Zobrist::compute_material_key(this);
+    return FenResult(SuccessfulOperation {});
+}
 
-    //handling en passant square
-    if (fen[i] != '-') {
-        size_t en_passant_index = Move::Move::string_to_index(fen.substr(i, 2));
-        this->en_passant = {en_passant_index};
-        i += 2;
-    } else {
-        i++;
+std::string_view Board::Board::to_fen(FenBuffer *buffer) const {
+    char *out = buffer->data();
+    for (size_t rank = 8; rank-- > 0;) {
+        size_t empty = 0;
+        for (size_t file = 0; file < 8; file++) {
+            const std::optional<Move::Piece> &piece = this->board[Move::Move::coord_to_index(rank, file)];
+            if (!piece.has_value()) {
+                empty += 1;
+                continue;
+            }
+            if (empty > 0) {
+                *out++ = (char) ('0' + empty);
+                empty = 0;
+            }
+            *out++ = piece_to_fen_char(piece.value());
+        }
+        if (empty > 0) {
+            *out++ = (char) ('0' + empty);
+        }
+        if (rank > 0) {
+            *out++ = '/';
+        }
     }
 
-    //account for space
-    i++;
+    *out++ = ' ';
+    *out++ = this->current_player == Move::Color::White ? 'w' : 'b';
 
-    //handle moves since last pawn move or capture
-    size_t len = 0;
-    while (true) {
-        if (i + len >= fen.length()) {
-            throw std::invalid_argument("expected number for total moves");
-        } else if (fen[i + len] == ' ') {
-            this->moves_since_last_pawn_move_or_capture = atoi(fen.substr(i, len).c_str());
-            i += len;
-            break;
-        }
-        len += 1;
+    *out++ = ' ';
+    char *castling_start = out;
+    if (this->can_white_kingside_castle) {
+        *out++ = 'K';
+    }
+    if (this->can_white_queenside_castle) {
+        *out++ = 'Q';
+    }
+    if (this->can_black_kingside_castle) {
+        *out++ = 'k';
+    }
+    if (this->can_black_queenside_castle) {
+        *out++ = 'q';
+    }
+    if (out == castling_start) {
+        *out++ = '-';
     }
 
-    //acount for space
-    i++;
+    *out++ = ' ';
+    if (this->en_passant.has_value()) {
+        *out++ = (char) ('a' + this->en_passant.value() % 8);
+        *out++ = (char) ('1' + this->en_passant.value() / 8);
+    } else {
+        *out++ = '-';
+    }
 
-    //handle moves since last pawn move or capture
-    len = 0;
-    while (true) {
-        if (i + len >= fen.length() || fen[i + len] == ' ') {
-            this->num_moves = atoi(fen.substr(i, len).c_str());
-            i += len;
+    //MAX_FEN_LENGTH leaves room for both counters, the checks keep the writes in bounds regardless
+    char *end = buffer->data() + buffer->size();
+    for (size_t counter : {this->moves_since_last_pawn_move_or_capture, this->num_moves}) {
+        if (out == end) {
             break;
         }
-        len += 1;
+        *out++ = ' ';
+        std::to_chars_result result = std::to_chars(out, end, counter);
+        if (result.ec != std::errc()) {
+            break;
+        }
+        out = result.ptr;
     }
+    return std::string_view(buffer->data(), out - buffer->data());
 }
 
 bool Board::Board::is_piece_at_index(Move::Index index) const {
@@ -213,9 +345,153 @@ std::optional<Move::Index> Board::Board::get_king_index(Move::Color color) const
     return std::nullopt;
 }
 
+//(rank, file) steps used for attack detection
+const std::array<std::tuple<int32_t, int32_t>, 8> KNIGHT_STEPS = {{
+    {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}
+}};
+const std::array<std::tuple<int32_t, int32_t>, 8> KING_STEPS = {{
+    {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+}};
+const std::array<std::tuple<int32_t, int32_t>, 4> ORTHOGONAL_STEPS = {{
+    {1, 0}, {-1, 0}, {0, 1}, {0, -1}
+}};
+const std::array<std::tuple<int32_t, int32_t>, 4> DIAGONAL_STEPS = {{
+    {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+}};
+
+std::vector<Move::Index> Board::Board::get_attackers(Move::Index index, Move::Color attacking_color) const {
+    std::vector<Move::Index> attackers = std::vector<Move::Index>();
+    auto [rank, file] = Move::Move::index_to_coord(index);
+    auto is_attacker = [this, attacking_color](Move::Index i, Move::PieceType piece_type) {
+        return this->board[i].has_value()
+            && this->board[i].value().color == attacking_color
+            && this->board[i].value().piece_type == piece_type;
+    };
+
+    //a pawn attacks diagonally forwards, so look one rank behind the square from the attacker's point of view
+    int32_t pawn_rank = (int32_t) rank + (attacking_color == Move::Color::White ? -1 : 1);
+    if (pawn_rank >= 0 && pawn_rank < 8) {
+        if (file > 0 && is_attacker(Move::Move::coord_to_index(pawn_rank, file - 1), Move::PieceType::Pawn)) {
+            attackers.push_back(Move::Move::coord_to_index(pawn_rank, file - 1));
+        }
+        if (file < 7 && is_attacker(Move::Move::coord_to_index(pawn_rank, file + 1), Move::PieceType::Pawn)) {
+            attackers.push_back(Move::Move::coord_to_index(pawn_rank, file + 1));
+        }
+    }
+
+    for (auto [dr, df] : KNIGHT_STEPS) {
+        int32_t r = (int32_t) rank + dr;
+        int32_t f = (int32_t) file + df;
+        if (r >= 0 && r < 8 && f >= 0 && f < 8 && is_attacker(Move::Move::coord_to_index(r, f), Move::PieceType::Knight)) {
+            attackers.push_back(Move::Move::coord_to_index(r, f));
+        }
+    }
+
+    for (auto [dr, df] : KING_STEPS) {
+        int32_t r = (int32_t) rank + dr;
+        int32_t f = (int32_t) file + df;
+        if (r >= 0 && r < 8 && f >= 0 && f < 8 && is_attacker(Move::Move::coord_to_index(r, f), Move::PieceType::King)) {
+            attackers.push_back(Move::Move::coord_to_index(r, f));
+        }
+    }
+
+    auto scan_rays = [&](auto steps, Move::PieceType slider) {
+        for (auto [dr, df] : steps) {
+            int32_t r = (int32_t) rank + dr;
+            int32_t f = (int32_t) file + df;
+            while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+                Move::Index i = Move::Move::coord_to_index(r, f);
+                if (this->board[i].has_value()) {
+                    if (is_attacker(i, slider) || is_attacker(i, Move::PieceType::Queen)) {
+                        attackers.push_back(i);
+                    }
+                    break;
+                }
+                r += dr;
+                f += df;
+            }
+        }
+    };
+    scan_rays(ORTHOGONAL_STEPS, Move::PieceType::Rook);
+    scan_rays(DIAGONAL_STEPS, Move::PieceType::Bishop);
+
+    return attackers;
+}
+
+bool Board::Board::is_square_attacked(Move::Index index, Move::Color attacking_color) const {
+    return !this->get_attackers(index, attacking_color).empty();
+}
+
+bool Board::Board::is_in_check(Move::Color color) const {
+    auto king_index = this->get_king_index(color);
+    if (!king_index.has_value()) {
+        return false;
+    }
+    return this->is_square_attacked(king_index.value(), Move::swap(color));
+}
+
+bool Board::Board::is_repetition(size_t ply) const {
+    //positions before the last pawn move or capture can never come back
+    size_t reversible_plies = std::min(this->moves_since_last_pawn_move_or_capture, this->key_history.size());
+    size_t occurrences = 0;
+    //only positions with the same player to move can be equal, so step back two plies at a time
+    for (size_t distance = 2; distance <= reversible_plies; distance += 2) {
+        if (this->key_history[this->key_history.size() - distance] == this->key) {
+            if (distance <= ply) {
+                return true;
+            }
+            occurrences += 1;
+            if (occurrences >= 2) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Board::Board::has_insufficient_material() const {
+    size_t minor_pieces = 0;
+    std::optional<size_t> bishop_square_color = std::nullopt;
+    bool bishops_on_both_colors = false;
+    bool has_knight = false;
+    for (Move::Index i = 0; i < std::size(this->board); i++) {
+        if (!this->board[i].has_value()) {
+            continue;
+        }
+        switch (this->board[i].value().piece_type) {
+        case Move::PieceType::King:
+            break;
+        case Move::PieceType::Knight:
+            minor_pieces += 1;
+            has_knight = true;
+            break;
+        case Move::PieceType::Bishop: {
+            minor_pieces += 1;
+            auto [rank, file] = Move::Move::index_to_coord(i);
+            size_t square_color = (rank + file) % 2;
+            if (bishop_square_color.has_value() && bishop_square_color.value() != square_color) {
+                bishops_on_both_colors = true;
+            }
+            bishop_square_color = square_color;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    //a lone minor piece, or only bishops that all travel on the same color, can't force mate
+    return minor_pieces <= 1 || (!has_knight && !bishops_on_both_colors);
+}
+
+bool Board::Board::is_draw(size_t ply) const {
+    return this->moves_since_last_pawn_move_or_capture >= FIFTY_MOVE_RULE_PLIES
+        || this->is_repetition(ply)
+        || this->has_insufficient_material();
+}
+
 bool Board::Board::get_queenside_castle_for_color(Move::Color color) const {
     if (color == Move::Color::White) {
-        return this->can_black_kingside_castle;
+        return this->can_white_queenside_castle;
     }
     return this->can_black_queenside_castle;
 }
@@ -224,7 +500,7 @@ bool Board::Board::get_kingside_castle_for_color(Move::Color color) const {
     if (color == Move::Color::White) {
         return this->can_white_kingside_castle;
     }
-    return this->can_white_queenside_castle;
+    return this->can_black_kingside_castle;
 }
 
 Move::Index Board::Board::get_default_queenside_rook_for_color(Move::Color color) {
@@ -266,39 +542,81 @@ Board::MoveResult Board::Board::is_valid_move(Move::Move *move) {
         return MoveResult(MoveError::InvalidMove);
     }
 
-    move->capture = this->board[move->to];
-    this->board[move->to] = this->board[move->from];
-    this->board[move->from] = std::nullopt;
+    //a pawn reaching the last rank has to promote to a knight, bishop, rook or queen of its own color,
+    //and no other move promotes
+    bool reaches_last_rank = piece.piece_type == Move::PieceType::Pawn && (move->to / 8 == 0 || move->to / 8 == 7);
+    if (reaches_last_rank != move->promotion.has_value()) {
+        return MoveResult(MoveError::InvalidMove);
+    } else if (move->promotion.has_value() && (
+        move->promotion.value().color != piece.color
+        || move->promotion.value().piece_type == Move::PieceType::Pawn
+        || move->promotion.value().piece_type == Move::PieceType::King
+    )) {
+        return MoveResult(MoveError::InvalidMove);
+    }
 
-    Move::swap_ptr(&this->current_player);
+    this->make_move(move);
+    bool has_king = this->get_king_index(piece.color).has_value();
+    bool is_king_attacked = this->is_in_check(piece.color);
+    this->unmake_move(move);
 
-    auto king_index = this->get_king_index(piece.color);
-    if (!king_index.has_value()) {
+    if (!has_king) {
         return MoveResult(MoveError::NoKing);
     }
-    auto potential_captures = Move::Piece::generate_capture_moves(this, piece.color);
-    if (std::find(potential_captures.begin(), potential_captures.end(), king_index.value()) != potential_captures.end()) {
+    if (is_king_attacked) {
         return MoveResult(MoveError::KingLeftInCheck);
     }
 
-    this->board[move->from] = this->board[move->to];
-    this->board[move->to] = move->capture;
-    Move::swap_ptr(&this->current_player);
-
     return MoveResult(SuccessfulOperation {});
 }
 
+bool Board::Board::is_en_passant_capture(Move::Move *move, Move::Piece moving_piece) {
+    return moving_piece.piece_type == Move::PieceType::Pawn
+        && move->previous_en_passant.has_value()
+        && move->previous_en_passant.value() == move->to
+        && move->from % 8 != move->to % 8;
+}
+
+Move::Index Board::Board::get_en_passant_captured_index(Move::Move *move) {
+    //the captured pawn is beside the capturing one: on its rank and the target's file
+    return Move::Move::coord_to_index(move->from / 8, move->to % 8);
+}
+
 void Board::Board::make_move(Move::Move *move) {
     Move::Piece moving_piece = this->board[move->from].value();
+    move->lost_castling_rights = Move::CastlingRights::None;
+    move->previous_en_passant = this->en_passant;
+    move->previous_moves_since_last_pawn_move_or_capture = this->moves_since_last_pawn_move_or_capture;
+    move->previous_key = this->key;
+    move->previous_pawn_key = this->pawn_key;
+    move->previous_material_key = this->material_key;
+    this->key_history.push_back(this->key);
+    //castling rights and en passant are hashed back in once they are updated
+    this->key ^= Zobrist::castling_key(this) ^ Zobrist::en_passant_key(this->en_passant);
     bool moved_two_squares_forward = (move->from < move->to ? move->to - move->from : move->from - move->to) == 16;
     bool was_piece_pawn = moving_piece.piece_type == Move::PieceType::Pawn;
     if (moved_two_squares_forward && was_piece_pawn) {
-        this->en_passant = std::optional(move->to);
+        //the square the pawn skipped over
+        this->en_passant = std::optional((move->from + move->to) / 2);
     } else {
         this->en_passant = std::nullopt;
     }
 
     move->capture = this->board[move->to];
+    if (is_en_passant_capture(move, moving_piece)) {
+        Move::Index captured_index = get_en_passant_captured_index(move);
+        move->capture = this->board[captured_index];
+        this->board[captured_index] = std::nullopt;
+        this->key ^= Zobrist::piece_key(move->capture.value(), captured_index);
+        this->pawn_key ^= Zobrist::piece_key(move->capture.value(), captured_index);
+        this->material_key -= Zobrist::material_key_unit(move->capture.value());
+    } else if (move->capture.has_value()) {
+        this->key ^= Zobrist::piece_key(move->capture.value(), move->to);
+        this->material_key -= Zobrist::material_key_unit(move->capture.value());
+        if (move->capture.value().piece_type == Move::PieceType::Pawn) {
+            this->pawn_key ^= Zobrist::piece_key(move->capture.value(), move->to);
+        }
+    }
 
     //handle castling rights
     Move::Index default_king_space = moving_piece.color == Move::Color::White ?
@@ -343,17 +661,29 @@ void Board::Board::make_move(Move::Move *move) {
         this->moves_since_last_pawn_move_or_capture += 1;
     }
 
+    this->key ^= Zobrist::piece_key(moving_piece, move->from) ^ Zobrist::piece_key(moving_piece, move->to);
+    if (was_piece_pawn) {
+        this->pawn_key ^= Zobrist::piece_key(moving_piece, move->from) ^ Zobrist::piece_key(moving_piece, move->to);
+    }
     this->board[move->to] = this->board[move->from];
     this->board[move->from] = std::nullopt;
+    if (move->promotion.has_value()) {
+        this->key ^= Zobrist::piece_key(moving_piece, move->to) ^ Zobrist::piece_key(move->promotion.value(), move->to);
+        this->pawn_key ^= Zobrist::piece_key(moving_piece, move->to);
+        this->material_key += Zobrist::material_key_unit(move->promotion.value()) - Zobrist::material_key_unit(moving_piece);
+        this->board[move->to] = move->promotion;
+    }
 
     //handle castling
     if (moving_piece.piece_type == Move::PieceType::King && move->from == Board::get_default_king_for_color(moving_piece.color)) {
         if (move->to - move->from == 2) {
+            Move::Piece rook = Move::Piece(moving_piece.color, Move::PieceType::Rook);
+            this->key ^= Zobrist::piece_key(rook, Board::get_default_kingside_rook_for_color(moving_piece.color))
+                ^ Zobrist::piece_key(rook, Board::get_default_king_for_color(moving_piece.color) + 1);
             this->board[Board::get_default_kingside_rook_for_color(moving_piece.color)] = std::nullopt;
             this->board[Board::get_default_king_for_color(moving_piece.color) + 1] = {
                 Move::Piece(moving_piece.color, Move::PieceType::Rook)
             };
-            move->lost_castling_rights = Move::CastlingRights::Both;
             if (moving_piece.color == Move::Color::White) {
                 this->can_white_kingside_castle = false;
                 this->can_white_queenside_castle = false;
@@ -362,11 +692,13 @@ void Board::Board::make_move(Move::Move *move) {
                 this->can_black_queenside_castle = false;
             }
         } else if (move->from - move->to == 2) {
+            Move::Piece rook = Move::Piece(moving_piece.color, Move::PieceType::Rook);
+            this->key ^= Zobrist::piece_key(rook, Board::get_default_queenside_rook_for_color(moving_piece.color))
+                ^ Zobrist::piece_key(rook, Board::get_default_king_for_color(moving_piece.color) - 1);
             this->board[Board::get_default_queenside_rook_for_color(moving_piece.color)] = std::nullopt;
             this->board[Board::get_default_king_for_color(moving_piece.color) - 1] = {
                 Move::Piece(moving_piece.color, Move::PieceType::Rook)
             };
-            move->lost_castling_rights = Move::CastlingRights::Both;
             if (moving_piece.color == Move::Color::White) {
                 this->can_white_kingside_castle = false;
                 this->can_white_queenside_castle = false;
@@ -380,14 +712,32 @@ void Board::Board::make_move(Move::Move *move) {
         this->num_moves += 1;
     }
     Move::swap_ptr(&this->current_player);
+    this->key ^= Zobrist::castling_key(this) ^ Zobrist::en_passant_key(this->en_passant) ^ Zobrist::side_key();
 }
 
 void Board::Board::unmake_move(Move::Move *move) {
     Move::Piece moving_piece = this->board[move->to].value();
+    if (move->promotion.has_value()) {
+        moving_piece = Move::Piece(moving_piece.color, Move::PieceType::Pawn);
+    }
 
-    this->board[move->from] = this->board[move->to];
-    this->board[move->to] = move->capture;
+    this->board[move->from] = moving_piece;
+    if (is_en_passant_capture(move, moving_piece)) {
+        this->board[move->to] = std::nullopt;
+        this->board[get_en_passant_captured_index(move)] = move->capture;
+    } else {
+        this->board[move->to] = move->capture;
+    }
     this->current_player = Move::swap(this->current_player);
+    this->en_passant = move->previous_en_passant;
+    this->moves_since_last_pawn_move_or_capture = move->previous_moves_since_last_pawn_move_or_capture;
+    this->key = move->previous_key;
+    this->pawn_key = move->previous_pawn_key;
+    this->material_key = move->previous_material_key;
+    this->key_history.pop_back();
+    if (this->current_player == Move::Color::Black) {
+        this->num_moves -= 1;
+    }
 
     //handling undoing castling
     if (moving_piece.piece_type == Move::PieceType::King && move->from == Board::get_default_king_for_color(moving_piece.color)) {
@@ -8,7 +8,9 @@
 #include <array>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
 #include "move.h"
 
@@ -19,6 +21,11 @@ namespace Board {
     const Move::Index DEFAULT_BLACK_QUEENSIDE_ROOK_INDEX = 56;
     const Move::Index DEFAULT_BLACK_KING_INDEX = 60;
     const Move::Index DEFAULT_BLACK_KINGSIDE_ROOK_INDEX = 63;
+    //Forsyth Edwards notation for position:
+    // pieces, player to move, castling rights, en passant, 50 move rule, total ply
+    const std::string STARTPOS = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    //half moves without a pawn move or capture after which the game is drawn
+    const size_t FIFTY_MOVE_RULE_PLIES = 100;
 
     struct SuccessfulOperation {};
 
@@ -32,17 +39,53 @@ namespace Board {
 
     typedef std::variant<SuccessfulOperation, MoveError> MoveResult;
 
+    enum FenError {
+        InvalidPiecePlacement,
+        //each side needs exactly one king
+        InvalidKings,
+        InvalidSideToMove,
+        InvalidCastlingRights,
+        //also when no pawn of the side that just moved could have skipped over the square
+        InvalidEnPassant,
+        InvalidHalfmoveClock,
+        InvalidFullmoveNumber,
+        UnexpectedCharacters
+    };
+
+    typedef std::variant<SuccessfulOperation, FenError> FenResult;
+
+    //longest fen to_fen can write: 64 squares, 7 slashes, the other fields and two 20 digit counters
+    const size_t MAX_FEN_LENGTH = 128;
+    typedef std::array<char, MAX_FEN_LENGTH> FenBuffer;
+
     class Board {
     public:
         std::array<std::optional<Move::Piece>, 64> board;
         Move::Color current_player;
         bool can_white_kingside_castle, can_white_queenside_castle, can_black_kingside_castle, can_black_queenside_castle;
+        //square a pawn skipped over by moving two squares on the last move
         std::optional<size_t> en_passant;
         //for fifty-move rule
         size_t moves_since_last_pawn_move_or_capture;
         size_t num_moves;
+        //zobrist hash of the position
+        uint64_t key;
+        //zobrist hash of the pawns alone, which changes far less often and keys the pawn hash table
+        uint64_t pawn_key;
+        //how many of each piece there are, see Zobrist::material_key_unit. Keys the material hash table
+        uint64_t material_key;
+        //keys of every earlier position, including the moves of the position command, most recent last
+        std::vector<uint64_t> key_history;
 
-        Board (std::string fen);
+        //an empty board, to be set up with set_fen
+        Board();
+        //throws std::invalid_argument if the fen is invalid
+        Board (std::string_view fen);
+        //sets up the position of fen without allocating, leaving the board untouched if fen is invalid.
+        //the move counters may be left out, as in epd
+        FenResult set_fen(std::string_view fen);
+        //writes the position into buffer without allocating, the returned view points into buffer
+        std::string_view to_fen(FenBuffer *buffer) const;
         //returns true if a piece exists at the index
         bool is_piece_at_index(Move::Index index) const;
         //returns true if a piece exists at the index and if the piece is the opposite color to capturing_color
@@ -51,6 +94,19 @@ namespace Board {
         bool can_piece_move_to_square(Move::Index index, Move::Color capturing_color) const;
         //gets index of the king
         std::optional<Move::Index> get_king_index(Move::Color color) const;
+        //returns the indices of every piece of attacking_color that attacks the index
+        std::vector<Move::Index> get_attackers(Move::Index index, Move::Color attacking_color) const;
+        //returns true if any piece of attacking_color attacks the index
+        bool is_square_attacked(Move::Index index, Move::Color attacking_color) const;
+        //returns true if the king of color is attacked by the other player
+        bool is_in_check(Move::Color color) const;
+        //true if the position occurred before. Repeating a position reached within the last ply
+        //half moves (so during the search) is enough, earlier ones have to occur twice before
+        bool is_repetition(size_t ply) const;
+        //true if neither player has enough material left to checkmate
+        bool has_insufficient_material() const;
+        //repetition, fifty-move rule or insufficient material
+        bool is_draw(size_t ply) const;
 
         bool get_queenside_castle_for_color(Move::Color color) const;
         bool get_kingside_castle_for_color(Move::Color color) const;
@@ -60,6 +116,9 @@ namespace Board {
 
         //is valid move is not const because it uses make move to check for attacks on king
         MoveResult is_valid_move(Move::Move *move);
+        //true if move is a pawn capturing en passant, only valid once make_move has saved the en passant square
+        static bool is_en_passant_capture(Move::Move *move, Move::Piece moving_piece);
+        static Move::Index get_en_passant_captured_index(Move::Move *move);
         void make_move(Move::Move *move);
         void unmake_move(Move::Move *move);
         void print_board() const;
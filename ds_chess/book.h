@@ -0,0 +1,51 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+
+#include "board.h"
+#include "mapped_file.h"
+#include "move.h"
+
+//opening books in the polyglot format: 16 byte big endian entries of (key, move, weight, learn), sorted by key.
+//the keys are polyglot's (piece/square, castling, capturable en passant file, white to move from its published
+//random table), so third party books and the ones buildbook writes can be used by any polyglot reader
+namespace Book {
+    const size_t ENTRY_SIZE = 16;
+
+    struct Entry {
+        uint64_t key;
+        //to file, to rank, from file, from rank and promotion piece, 3 bits each from the lowest.
+        //castling is written as the king taking its own rook
+        uint16_t move;
+        uint16_t weight;
+        uint32_t learn;
+    };
+
+    uint64_t polyglot_key(Board::Board *board);
+    uint16_t encode_move(Board::Board *board, Move::Move *move);
+    //nullopt if the book move isn't legal in the position
+    std::optional<Move::Move> decode_move(Board::Board *board, uint16_t move);
+
+    void write_entry(Entry *entry, uint8_t *out);
+    Entry read_entry(const uint8_t *in);
+
+    class Book {
+    public:
+        Book();
+        //false if path can't be mapped or isn't a whole number of entries
+        bool open(const std::string &path);
+        void close();
+        bool is_open() const;
+        //a random book move, more likely the higher its weight, nullopt once out of book
+        std::optional<Move::Move> probe(Board::Board *board);
+    private:
+        MappedFile::MappedFile file;
+        std::mt19937_64 random;
+    };
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "endgame.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <initializer_list>
+#include <tuple>
+
+#include "bitbase.h"
+#include "evaluation.h"
+
+//the pieces of color other than king and pawns
+static size_t piece_count(uint64_t key, Move::Color color) {
+    return MaterialTable::piece_count(key, color, Move::PieceType::Knight)
+        + MaterialTable::piece_count(key, color, Move::PieceType::Bishop)
+        + MaterialTable::piece_count(key, color, Move::PieceType::Rook)
+        + MaterialTable::piece_count(key, color, Move::PieceType::Queen);
+}
+
+//whether color has the lone pieces of piece_types (and nothing else but its king) while the other side
+//has a bare king
+static bool is_against_bare_king(uint64_t key, Move::Color color, std::initializer_list<Move::PieceType> piece_types) {
+    Move::Color them = Move::swap(color);
+    if (piece_count(key, them) != 0 || MaterialTable::piece_count(key, them, Move::PieceType::Pawn) != 0) {
+        return false;
+    }
+    size_t pawns = 0;
+    size_t pieces = 0;
+    for (Move::PieceType piece_type : piece_types) {
+        if (MaterialTable::piece_count(key, color, piece_type) != 1) {
+            return false;
+        }
+        (piece_type == Move::PieceType::Pawn ? pawns : pieces) += 1;
+    }
+    return MaterialTable::piece_count(key, color, Move::PieceType::Pawn) == pawns && piece_count(key, color) == pieces;
+}
+
+static int32_t distance(Move::Index a, Move::Index b) {
+    auto [rank_a, file_a] = Move::Move::index_to_coord(a);
+    auto [rank_b, file_b] = Move::Move::index_to_coord(b);
+    return std::max(std::abs((int32_t) rank_a - (int32_t) rank_b), std::abs((int32_t) file_a - (int32_t) file_b));
+}
+
+MaterialTable::EvaluationFunction Endgame::find_evaluation(uint64_t material_key) {
+    for (Move::Color color : {Move::Color::White, Move::Color::Black}) {
+        if (is_against_bare_king(material_key, color, {Move::PieceType::Pawn})
+            || is_against_bare_king(material_key, color, {Move::PieceType::Rook})
+            || is_against_bare_king(material_key, color, {Move::PieceType::Queen})
+            || is_against_bare_king(material_key, color, {Move::PieceType::Bishop, Move::PieceType::Knight})) {
+            return evaluate_bitbase;
+        }
+
+        Move::Color them = Move::swap(color);
+        bool rook_only = piece_count(material_key, color) == 1
+            && MaterialTable::piece_count(material_key, color, Move::PieceType::Rook) == 1
+            && MaterialTable::piece_count(material_key, color, Move::PieceType::Pawn) == 0;
+        bool pawn_only = piece_count(material_key, them) == 0
+            && MaterialTable::piece_count(material_key, them, Move::PieceType::Pawn) == 1;
+        if (rook_only && pawn_only) {
+            return evaluate_krkp;
+        }
+    }
+    return nullptr;
+}
+
+MaterialTable::ScaleFunction Endgame::find_scale(uint64_t material_key) {
+    for (Move::Color color : {Move::Color::White, Move::Color::Black}) {
+        if (piece_count(material_key, color) != 1
+            || MaterialTable::piece_count(material_key, color, Move::PieceType::Bishop) != 1) {
+            return nullptr;
+        }
+    }
+    return scale_opposite_bishops;
+}
+
+std::optional<float> Endgame::evaluate_bitbase(Board::Board *board) {
+    std::optional<Bitbase::Probe> probe = Bitbase::probe(board);
+    if (!probe.has_value()) {
+        return std::nullopt;
+    }
+    return Evaluation::evaluate_known_endgame(&probe.value());
+}
+
+std::optional<float> Endgame::evaluate_krkp(Board::Board *board) {
+    std::optional<Move::Index> rook = std::nullopt;
+    std::optional<Move::Index> pawn = std::nullopt;
+    for (Move::Index i = 0; i < 64; i++) {
+        if (!board->board[i].has_value()) {
+            continue;
+        }
+        if (board->board[i].value().piece_type == Move::PieceType::Rook) {
+            rook = i;
+        } else if (board->board[i].value().piece_type == Move::PieceType::Pawn) {
+            pawn = i;
+        }
+    }
+    Move::Color strong_side = board->board[rook.value()].value().color;
+    Move::Color weak_side = Move::swap(strong_side);
+    std::optional<Move::Index> strong_king = board->get_king_index(strong_side);
+    std::optional<Move::Index> weak_king = board->get_king_index(weak_side);
+    if (!strong_king.has_value() || !weak_king.has_value()) {
+        return std::nullopt;
+    }
+
+    //flipped so the pawn moves down the board
+    Move::Index flip = weak_side == Move::Color::White ? 56 : 0;
+    Move::Index rook_square = rook.value() ^ flip;
+    Move::Index pawn_square = pawn.value() ^ flip;
+    Move::Index strong_square = strong_king.value() ^ flip;
+    Move::Index weak_square = weak_king.value() ^ flip;
+    auto [pawn_rank, pawn_file] = Move::Move::index_to_coord(pawn_square);
+    auto [strong_rank, strong_file] = Move::Move::index_to_coord(strong_square);
+    size_t weak_rank = std::get<0>(Move::Move::index_to_coord(weak_square));
+    Move::Index queening_square = Move::Move::coord_to_index(0, pawn_file);
+    Move::Index stop_square = pawn_square - 8;
+    int32_t weak_to_move = board->current_player == weak_side ? 1 : 0;
+
+    float score;
+    if (strong_file == pawn_file && strong_rank < pawn_rank) {
+        score = Evaluation::get_piece_type_value(Move::PieceType::Rook)
+            - KRKP_KING_DISTANCE_PENALTY * distance(strong_square, pawn_square);
+    } else if (distance(weak_square, pawn_square) >= 3 + weak_to_move && distance(weak_square, rook_square) >= 3) {
+        score = Evaluation::get_piece_type_value(Move::PieceType::Rook)
+            - KRKP_KING_DISTANCE_PENALTY * distance(strong_square, pawn_square);
+    } else if (weak_rank <= 2 && distance(weak_square, pawn_square) == 1 && strong_rank >= 3
+        && distance(strong_square, pawn_square) > 2 + (1 - weak_to_move)) {
+        score = KRKP_DRAWISH_SCORE - KRKP_DISTANCE_STEP * distance(strong_square, pawn_square);
+    } else {
+        score = KRKP_UNCLEAR_SCORE - KRKP_DISTANCE_STEP * (
+            distance(strong_square, stop_square)
+            - distance(weak_square, stop_square)
+            - distance(pawn_square, queening_square)
+        );
+    }
+    return strong_side == Move::Color::White ? score : -score;
+}
+
+float Endgame::scale_opposite_bishops(Board::Board *board) {
+    std::array<size_t, 2> square_colors = {0, 0};
+    for (Move::Index i = 0; i < 64; i++) {
+        if (board->board[i].has_value() && board->board[i].value().piece_type == Move::PieceType::Bishop) {
+            auto [rank, file] = Move::Move::index_to_coord(i);
+            square_colors[board->board[i].value().color] = (rank + file) % 2;
+        }
+    }
+    return square_colors[0] != square_colors[1] ? OPPOSITE_BISHOPS_SCALE : 1.0f;
+}
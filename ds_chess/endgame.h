@@ -0,0 +1,37 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <cstdint>
+#include <optional>
+
+#include "board.h"
+#include "material_table.h"
+
+//evaluation and scaling functions of endgames the usual terms get wrong. Which one applies only
+//depends on the piece counts, so it's picked once per material key and kept in the material table
+namespace Endgame {
+    //KRKP: the rook wins when its king is in front of the pawn or the pawn's king is too far away,
+    //scoring the rook less this much for each square its king is from the pawn
+    const float KRKP_KING_DISTANCE_PENALTY = 0.1;
+    //a pawn far up the board with its king beside it and the other king far away is close to a draw
+    const float KRKP_DRAWISH_SCORE = 0.4;
+    //otherwise the rook is a little ahead, by how much depending on which king gets to the pawn first
+    const float KRKP_UNCLEAR_SCORE = 1.0;
+    //per square of king distances in the drawish and unclear cases
+    const float KRKP_DISTANCE_STEP = 0.04;
+    //share of the evaluation kept when the only pieces are bishops on opposite colors
+    const float OPPOSITE_BISHOPS_SCALE = 0.5;
+
+    //the evaluation function for the piece counts of material_key, nullptr if there is none
+    MaterialTable::EvaluationFunction find_evaluation(uint64_t material_key);
+    //the scaling function for the piece counts of material_key, nullptr if there is none
+    MaterialTable::ScaleFunction find_scale(uint64_t material_key);
+
+    //KPK, KRK, KQK and KBNK from their bitbases, once they're generated
+    std::optional<float> evaluate_bitbase(Board::Board *board);
+    std::optional<float> evaluate_krkp(Board::Board *board);
+    //one bishop each and nothing else but pawns, which is drawish when the bishops are on opposite colors
+    float scale_opposite_bishops(Board::Board *board);
+};
+
+#endif
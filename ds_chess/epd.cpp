@@ -0,0 +1,249 @@
+#include "epd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "bitbase.h"
+#include "board.h"
+#include "material_table.h"
+#include "pawn_table.h"
+#include "san.h"
+#include "transposition_table.h"
+
+//the result of one entry
+struct Outcome {
+    //in san, like the bm and am operations
+    std::optional<std::string> found;
+    bool solved;
+    //milliseconds from the start of the search until it settled on a solution for good
+    int64_t solve_time;
+    int64_t time;
+    uint64_t nodes;
+};
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::optional<EPD::Entry> EPD::parse_line(std::string_view line) {
+    StringHandling::Tokenizer tokens = StringHandling::Tokenizer(line);
+    if (!tokens.has_next() || tokens.peek().front() == '#') {
+        return std::nullopt;
+    }
+    std::string_view first = tokens.next();
+    std::string_view last = first;
+    for (size_t field = 1; field < 4; field++) {
+        if (!tokens.has_next()) {
+            return std::nullopt;
+        }
+        last = tokens.next();
+    }
+
+    Entry entry = Entry();
+    entry.position = StringHandling::span(first, last);
+
+    //operations: an opcode and its operands, ended by a semicolon, where string operands are quoted
+    std::string_view operations = tokens.rest();
+    while (!operations.empty()) {
+        size_t end = 0;
+        bool quoted = false;
+        while (end < operations.size() && (quoted || operations[end] != ';')) {
+            quoted = operations[end] == '"' ? !quoted : quoted;
+            end++;
+        }
+        std::string_view operation = trim(operations.substr(0, end));
+        operations = trim(operations.substr(std::min(end + 1, operations.size())));
+
+        StringHandling::Tokenizer operands = StringHandling::Tokenizer(operation);
+        std::string_view opcode = operands.next();
+        if (opcode == "id") {
+            std::string_view id = trim(operands.rest());
+            if (id.size() >= 2 && id.front() == '"' && id.back() == '"') {
+                id = id.substr(1, id.size() - 2);
+            }
+            entry.id = id;
+        } else if (opcode == "bm" || opcode == "am") {
+            std::vector<std::string> *moves = opcode == "bm" ? &entry.best_moves : &entry.avoid_moves;
+            while (operands.has_next()) {
+                moves->push_back(std::string(operands.next()));
+            }
+        }
+    }
+    return entry;
+}
+
+void EPD::epd_command(StringHandling::Tokenizer *tokens) {
+    std::string path = std::string(tokens->next());
+    Search::SearchLimits limits = Search::SearchLimits();
+    limits.silent = true;
+    TimeManager::TimeControl time_control = TimeManager::TimeControl();
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool limited = false;
+    while (tokens->has_next()) {
+        std::string_view token = tokens->next();
+        if (token == "depth") {
+            limits.depth = StringHandling::to_int(tokens->next());
+            limited = true;
+        } else if (token == "movetime") {
+            time_control.move_time = StringHandling::to_int(tokens->next());
+            limited = true;
+        } else if (token == "nodes") {
+            limits.nodes = std::max<int64_t>(0, StringHandling::to_int(tokens->next()));
+            limited = true;
+        } else if (token == "threads") {
+            threads = std::max<int64_t>(1, StringHandling::to_int(tokens->next()));
+        }
+    }
+    if (!limited) {
+        limits.depth = DEFAULT_DEPTH;
+    }
+
+    std::ifstream file = std::ifstream(path);
+    if (!file.is_open()) {
+        std::cout << "could not open " << path << std::endl;
+        return;
+    }
+    std::vector<Entry> entries = std::vector<Entry>();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::optional<Entry> entry = parse_line(line);
+        if (entry.has_value()) {
+            entries.push_back(entry.value());
+        }
+    }
+    run(&entries, limits, time_control, threads);
+}
+
+static Outcome solve(
+    EPD::Entry *entry,
+    Search::SearchLimits *limits,
+    TimeManager::TimeControl time_control,
+    TranspositionTable::TranspositionTable *transposition_table,
+    PawnTable::PawnTable *pawn_table,
+    MaterialTable::MaterialTable *material_table
+) {
+    Outcome outcome = Outcome {std::nullopt, false, 0, 0, 0};
+    Board::Board board = Board::Board();
+    if (std::holds_alternative<Board::FenError>(board.set_fen(entry->position))) {
+        return outcome;
+    }
+    std::vector<Move::Move> best_moves = std::vector<Move::Move>();
+    std::vector<Move::Move> avoid_moves = std::vector<Move::Move>();
+    for (std::string &san : entry->best_moves) {
+        std::optional<Move::Move> move = SAN::from_san(&board, san);
+        if (move.has_value()) {
+            best_moves.push_back(move.value());
+        }
+    }
+    for (std::string &san : entry->avoid_moves) {
+        std::optional<Move::Move> move = SAN::from_san(&board, san);
+        if (move.has_value()) {
+            avoid_moves.push_back(move.value());
+        }
+    }
+    auto is_solution = [&best_moves, &avoid_moves](Move::Move *move) {
+        if (!best_moves.empty() && std::find(best_moves.begin(), best_moves.end(), *move) == best_moves.end()) {
+            return false;
+        }
+        return std::find(avoid_moves.begin(), avoid_moves.end(), *move) == avoid_moves.end();
+    };
+
+    //entries are independent, so nothing may carry over from the previous one
+    transposition_table->clear();
+    TimeManager::TimeManager time_manager = TimeManager::TimeManager(time_control);
+    Search::SearchResult result = Search::init_search(limits, &board, &time_manager, transposition_table, pawn_table, material_table);
+    outcome.time = time_manager.elapsed();
+    outcome.nodes = result.nodes;
+    if (result.pv.empty() || (best_moves.empty() && avoid_moves.empty())) {
+        return outcome;
+    }
+    outcome.found = SAN::to_san(&board, &result.pv[0]);
+    outcome.solved = is_solution(&result.pv[0]);
+
+    //solved from the first iteration after the last one that picked a wrong move
+    outcome.solve_time = 0;
+    for (size_t i = 0; i < result.iterations.size(); i++) {
+        if (!is_solution(&result.iterations[i].best_move)) {
+            outcome.solve_time = i + 1 < result.iterations.size() ? result.iterations[i + 1].time : outcome.time;
+        }
+    }
+    return outcome;
+}
+
+void EPD::run(
+    std::vector<Entry> *entries,
+    Search::SearchLimits limits,
+    TimeManager::TimeControl time_control,
+    size_t threads
+) {
+    //the bitbases change how endgames are evaluated, so they're complete before any position is searched
+    Bitbase::init(threads);
+
+    std::atomic<size_t> next_entry = 0;
+    std::atomic<size_t> solved = 0;
+    std::atomic<uint64_t> nodes = 0;
+    size_t finished = 0;
+    std::mutex output_mutex;
+    auto start = std::chrono::steady_clock::now();
+
+    //every worker takes the next unsolved entry until there are none left
+    auto worker = [&]() {
+        Search::SearchLimits worker_limits = limits;
+        TranspositionTable::TranspositionTable transposition_table = TranspositionTable::TranspositionTable(
+            TranspositionTable::DEFAULT_SIZE_MB
+        );
+        PawnTable::PawnTable pawn_table = PawnTable::PawnTable(PawnTable::DEFAULT_SIZE);
+        MaterialTable::MaterialTable material_table = MaterialTable::MaterialTable(MaterialTable::DEFAULT_SIZE);
+        for (size_t i = next_entry++; i < entries->size(); i = next_entry++) {
+            Entry *entry = &(*entries)[i];
+            Outcome outcome = solve(entry, &worker_limits, time_control, &transposition_table, &pawn_table, &material_table);
+            nodes += outcome.nodes;
+            if (outcome.solved) {
+                solved += 1;
+            }
+
+            std::lock_guard<std::mutex> lock(output_mutex);
+            finished += 1;
+            std::cout << finished << "/" << entries->size()
+                << " " << (entry->id.empty() ? entry->position : entry->id)
+                << (outcome.solved ? " solved" : " failed");
+            for (std::string &move : entry->best_moves) {
+                std::cout << " bm " << move;
+            }
+            for (std::string &move : entry->avoid_moves) {
+                std::cout << " am " << move;
+            }
+            std::cout << " found " << outcome.found.value_or("none");
+            if (outcome.solved) {
+                std::cout << " solve-time " << outcome.solve_time;
+            }
+            std::cout << " time " << outcome.time << " nodes " << outcome.nodes << std::endl;
+        }
+    };
+
+    std::vector<std::thread> workers = std::vector<std::thread>();
+    for (size_t i = 0; i < std::min(threads, entries->size()); i++) {
+        workers.push_back(std::thread(worker));
+    }
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    int64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    std::cout << "solved " << solved << "/" << entries->size()
+        << " time " << time
+        << " nodes " << nodes
+        << " nps " << nodes * 1000 / std::max<int64_t>(time, 1) << std::endl;
+}
@@ -0,0 +1,43 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search.h"
+#include "string_handling.h"
+#include "time_manager.h"
+
+//extended position description test suites: positions with the best (bm) or avoided (am) moves
+namespace EPD {
+    //used when the command gives no depth, movetime or nodes
+    const int32_t DEFAULT_DEPTH = 6;
+
+    struct Entry {
+        //the four position fields, which set_fen accepts without move counters
+        std::string position;
+        std::string id;
+        //moves in standard algebraic notation
+        std::vector<std::string> best_moves;
+        std::vector<std::string> avoid_moves;
+    };
+
+    //nullopt for blank lines, comments and lines without a position
+    std::optional<Entry> parse_line(std::string_view line);
+
+    //epd <file> [depth <d> | movetime <ms> | nodes <n>] [threads <n>]
+    void epd_command(StringHandling::Tokenizer *tokens);
+    //solves every entry with its own searcher and transposition table, spread over threads,
+    //printing each result as it comes in and the number solved at the end
+    void run(
+        std::vector<Entry> *entries,
+        Search::SearchLimits limits,
+        TimeManager::TimeControl time_control,
+        size_t threads
+    );
+};
+
+#endif
@@ -4,59 +4,329 @@
 
 #include "evaluation.h"
 
-#include <numeric>
-#include <ranges>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <initializer_list>
+#include <tuple>
 
-float get_piece_value(Move::Piece piece) {
-    float value;
-    switch (piece.piece_type) {
+#include "endgame.h"
+
+float Evaluation::get_piece_type_value(Move::PieceType piece_type) {
+    switch (piece_type) {
         case Move::PieceType::Pawn:
-            value = 1.0;
-        break;
+            return 1.0;
         case Move::PieceType::Knight:
-            value = 2.9;
-        break;
+            return 2.9;
         case Move::PieceType::Bishop:
-            value = 3.1;
-        break;
+            return 3.1;
         case Move::PieceType::Rook:
-            value = 5.0;
-        break;
+            return 5.0;
         case Move::PieceType::Queen:
-            value = 9.0;
-        break;
+            return 9.0;
         case Move::PieceType::King:
-            value = 0.0;
-        break;
+            return 0.0;
         default:
             return 0.0;
     }
+}
 
+float Evaluation::get_piece_value(Move::Piece piece) {
+    float value = get_piece_type_value(piece.piece_type);
     float modifier = piece.color == Move::Color::White ? 1.0 : -1.0;
     return value * modifier;
 }
 
-float evaluate_board(Board::Board *board) {
-    auto is_space_occupied_filter = std::views::filter([](std::optional<Move::Piece> piece) {
-        return piece.has_value();
-    });
-    auto unwrap_transform = std::views::transform([](std::optional<Move::Piece> piece) {
-        return piece.value();
-    });
-    auto is_not_king_filter = std::views::filter([](Move::Piece piece) {
-        return piece.piece_type != Move::PieceType::King;
-    });
-    auto get_piece_value_transform = std::views::transform([] (Move::Piece piece) {
-        return get_piece_value(piece);
-    });
-
-    auto evaluatable_pieces = board->board
-        | is_space_occupied_filter
-        | unwrap_transform
-        | is_not_king_filter
-        | get_piece_value_transform;
-
-    return std::accumulate(evaluatable_pieces.begin(), evaluatable_pieces.end(), 0);
+float Evaluation::evaluate_board(
+    Board::Board *board,
+    PawnTable::PawnTable *pawn_table,
+    MaterialTable::MaterialTable *material_table
+) {
+    MaterialTable::Entry material = evaluate_material(board, material_table);
+    if (material.evaluation != nullptr) {
+        std::optional<float> eval = material.evaluation(board);
+        if (eval.has_value()) {
+            return eval.value();
+        }
+    }
+
+    PawnTable::Entry pawns = evaluate_pawn_structure(board, pawn_table);
+    float eval = material.score + pawns.score + evaluate_pawns_with_pieces(board, &pawns, material.phase);
+    if (material.scale != nullptr) {
+        eval *= material.scale(board);
+    }
+    return eval;
+}
+
+MaterialTable::Entry Evaluation::evaluate_material(Board::Board *board, MaterialTable::MaterialTable *material_table) {
+    std::optional<MaterialTable::Entry> cached = material_table->probe(board->material_key);
+    if (cached.has_value()) {
+        return cached.value();
+    }
+
+    MaterialTable::Entry entry = MaterialTable::Entry {};
+    entry.key = board->material_key;
+    for (Move::Color color : {Move::Color::White, Move::Color::Black}) {
+        auto count = [&](Move::PieceType piece_type) {
+            return MaterialTable::piece_count(board->material_key, color, piece_type);
+        };
+        int32_t knights = (int32_t) count(Move::PieceType::Knight);
+        int32_t bishops = (int32_t) count(Move::PieceType::Bishop);
+        int32_t rooks = (int32_t) count(Move::PieceType::Rook);
+        int32_t queens = (int32_t) count(Move::PieceType::Queen);
+        entry.phase += KNIGHT_PHASE * knights + BISHOP_PHASE * bishops + ROOK_PHASE * rooks + QUEEN_PHASE * queens;
+
+        float score = 0.0;
+        for (Move::PieceType piece_type : {
+            Move::PieceType::Pawn, Move::PieceType::Knight, Move::PieceType::Bishop,
+            Move::PieceType::Rook, Move::PieceType::Queen
+        }) {
+            score += get_piece_type_value(piece_type) * count(piece_type);
+        }
+        if (bishops >= 2) {
+            score += BISHOP_PAIR_BONUS;
+        }
+        float extra_pawns = (float) count(Move::PieceType::Pawn) - (float) IMBALANCE_PAWNS;
+        score += extra_pawns * (KNIGHT_PAWN_ADJUSTMENT * knights + ROOK_PAWN_ADJUSTMENT * rooks);
+        entry.score += color == Move::Color::White ? score : -score;
+    }
+    //promotions can take it past the starting pieces
+    entry.phase = std::min(entry.phase, MAX_PHASE);
+    entry.evaluation = Endgame::find_evaluation(entry.key);
+    entry.scale = Endgame::find_scale(entry.key);
+
+    material_table->store(&entry);
+    return entry;
+}
+
+//bitboards of the files, and of the ranks in front of a pawn from its color's point of view
+static uint64_t file_mask(size_t file) {
+    return 0x0101010101010101ULL << file;
+}
+
+static uint64_t adjacent_files_mask(size_t file) {
+    return (file > 0 ? file_mask(file - 1) : 0) | (file < 7 ? file_mask(file + 1) : 0);
+}
+
+static uint64_t forward_ranks_mask(Move::Color color, size_t rank) {
+    if (color == Move::Color::White) {
+        return rank >= 7 ? 0 : ~0ULL << (8 * (rank + 1));
+    }
+    return (1ULL << (8 * rank)) - 1;
+}
+
+static uint64_t pawn_attacks(Move::Color color, Move::Index index) {
+    auto [rank, file] = Move::Move::index_to_coord(index);
+    if ((color == Move::Color::White && rank == 7) || (color == Move::Color::Black && rank == 0)) {
+        return 0;
+    }
+    Move::Index ahead = color == Move::Color::White ? index + 8 : index - 8;
+    return (file > 0 ? 1ULL << (ahead - 1) : 0) | (file < 7 ? 1ULL << (ahead + 1) : 0);
+}
+
+static size_t relative_rank(Move::Color color, size_t rank) {
+    return color == Move::Color::White ? rank : 7 - rank;
+}
+
+PawnTable::Entry Evaluation::evaluate_pawn_structure(Board::Board *board, PawnTable::PawnTable *pawn_table) {
+    std::optional<PawnTable::Entry> cached = pawn_table->probe(board->pawn_key);
+    if (cached.has_value()) {
+        return cached.value();
+    }
+
+    PawnTable::Entry entry = PawnTable::Entry {};
+    entry.key = board->pawn_key;
+    for (Move::Index i = 0; i < 64; i++) {
+        if (board->board[i].has_value() && board->board[i].value().piece_type == Move::PieceType::Pawn) {
+            Move::Color color = board->board[i].value().color;
+            entry.pawns[color] |= 1ULL << i;
+            entry.attacks[color] |= pawn_attacks(color, i);
+        }
+    }
+
+    for (Move::Color color : {Move::Color::White, Move::Color::Black}) {
+        Move::Color them = Move::swap(color);
+        float score = 0.0;
+        for (uint64_t pawns = entry.pawns[color]; pawns != 0; pawns &= pawns - 1) {
+            Move::Index index = std::countr_zero(pawns);
+            auto [rank, file] = Move::Move::index_to_coord(index);
+            uint64_t front = forward_ranks_mask(color, rank);
+            uint64_t adjacent = adjacent_files_mask(file);
+            entry.attack_spans[color] |= front & adjacent;
+
+            bool passed = !(entry.pawns[them] & front & (file_mask(file) | adjacent));
+            bool isolated = !(entry.pawns[color] & adjacent);
+            bool doubled = entry.pawns[color] & front & file_mask(file);
+            //nothing beside or behind it on the neighbouring files, and its next square is guarded by a pawn
+            Move::Index stop = color == Move::Color::White ? index + 8 : index - 8;
+            bool backward = !passed && !isolated
+                && !(entry.pawns[color] & adjacent & ~front)
+                && (entry.attacks[them] & (1ULL << stop));
+
+            if (passed) {
+                entry.passed_pawns[color] |= 1ULL << index;
+                score += PASSED_PAWN_BONUS[relative_rank(color, rank)];
+            }
+            if (isolated) {
+                score -= ISOLATED_PAWN_PENALTY;
+            }
+            if (doubled) {
+                score -= DOUBLED_PAWN_PENALTY;
+            }
+            if (backward) {
+                score -= BACKWARD_PAWN_PENALTY;
+            }
+        }
+        entry.score += color == Move::Color::White ? score : -score;
+    }
+
+    pawn_table->store(&entry);
+    return entry;
+}
+
+float Evaluation::evaluate_pawns_with_pieces(Board::Board *board, PawnTable::Entry *pawns, int32_t phase) {
+    float middlegame = (float) phase / MAX_PHASE;
+    float eval = 0.0;
+    for (Move::Color color : {Move::Color::White, Move::Color::Black}) {
+        float score = 0.0;
+
+        std::optional<Move::Index> king = board->get_king_index(color);
+        if (king.has_value()) {
+            auto [rank, file] = Move::Move::index_to_coord(king.value());
+            if (relative_rank(color, rank) <= 1) {
+                size_t two_ahead = color == Move::Color::White ? rank + 2 : rank - 2;
+                uint64_t in_front = forward_ranks_mask(color, rank) & ~forward_ranks_mask(color, two_ahead);
+                uint64_t shield = in_front & (file_mask(file) | adjacent_files_mask(file));
+                score += middlegame * PAWN_SHIELD_BONUS * std::popcount(shield & pawns->pawns[color]);
+            }
+        }
+
+        for (uint64_t passed = pawns->passed_pawns[color]; passed != 0; passed &= passed - 1) {
+            Move::Index index = std::countr_zero(passed);
+            size_t rank = std::get<0>(Move::Move::index_to_coord(index));
+            Move::Index stop = color == Move::Color::White ? index + 8 : index - 8;
+            if (stop < 64 && !board->board[stop].has_value()) {
+                score += (1.0f - middlegame) * FREE_PASSED_PAWN_FACTOR * PASSED_PAWN_BONUS[relative_rank(color, rank)];
+            }
+        }
+        eval += color == Move::Color::White ? score : -score;
+    }
+    return eval;
+}
+
+float Evaluation::evaluate_known_endgame(Bitbase::Probe *probe) {
+    if (!probe->win) {
+        return 0.0;
+    }
+    auto distance = [](Move::Index a, Move::Index b) {
+        auto [rank_a, file_a] = Move::Move::index_to_coord(a);
+        auto [rank_b, file_b] = Move::Move::index_to_coord(b);
+        return (float) std::max(std::abs((int32_t) rank_a - (int32_t) rank_b), std::abs((int32_t) file_a - (int32_t) file_b));
+    };
+    auto [weak_rank, weak_file] = Move::Move::index_to_coord(probe->weak_king);
+
+    float score = KNOWN_WIN_SCORE + KNOWN_WIN_KING_BONUS * (7.0f - distance(probe->strong_king, probe->weak_king));
+    switch (probe->endgame) {
+        case Bitbase::KPK: {
+            auto [pawn_rank, pawn_file] = Move::Move::index_to_coord(probe->pieces[0]);
+            size_t advance = probe->strong_side == Move::Color::White ? pawn_rank : 7 - pawn_rank;
+            score += get_piece_type_value(Move::PieceType::Pawn) + KNOWN_WIN_PAWN_BONUS * advance;
+            break;
+        }
+        case Bitbase::KRK:
+        case Bitbase::KQK: {
+            size_t to_edge = std::min({weak_rank, 7 - weak_rank, weak_file, 7 - weak_file});
+            Move::PieceType piece_type = probe->endgame == Bitbase::KRK ? Move::PieceType::Rook : Move::PieceType::Queen;
+            score += get_piece_type_value(piece_type) + KNOWN_WIN_EDGE_BONUS * (3.0f - to_edge);
+            break;
+        }
+        case Bitbase::KBNK: {
+            //only the corners the bishop covers can be mated in
+            auto [bishop_rank, bishop_file] = Move::Move::index_to_coord(probe->pieces[0]);
+            bool dark_bishop = (bishop_rank + bishop_file) % 2 == 0;
+            float to_corner = dark_bishop
+                ? std::min(distance(probe->weak_king, 0), distance(probe->weak_king, 63))
+                : std::min(distance(probe->weak_king, 7), distance(probe->weak_king, 56));
+            score += get_piece_type_value(Move::PieceType::Bishop) + get_piece_type_value(Move::PieceType::Knight)
+                + KNOWN_WIN_EDGE_BONUS * (7.0f - to_corner);
+            break;
+        }
+    }
+    return probe->strong_side == Move::Color::White ? score : -score;
+}
+
+float Evaluation::evaluate_for_current_player(
+    Board::Board *board,
+    PawnTable::PawnTable *pawn_table,
+    MaterialTable::MaterialTable *material_table
+) {
+    float eval = evaluate_board(board, pawn_table, material_table);
+    return board->current_player == Move::Color::White ? eval : -eval;
+}
+
+float Evaluation::static_exchange_evaluation(Board::Board *board, Move::Move *move) {
+    auto see_value = [](Move::PieceType piece_type) {
+        return piece_type == Move::PieceType::King ? SEE_KING_VALUE : get_piece_type_value(piece_type);
+    };
+    if (!board->board[move->from].has_value()) {
+        return 0.0;
+    }
+
+    //pieces are lifted off the board as they capture, which uncovers x-ray attackers,
+    //and put back once the exchange is over
+    std::array<Move::Index, 32> lifted_indices = {};
+    std::array<std::optional<Move::Piece>, 32> lifted_pieces = {};
+    size_t lifted_count = 0;
+    Move::Index target = move->to;
+    Move::Color side = board->board[move->from].value().color;
+
+    //gains[d] is the material balance after the d-th capture from the point of view of the side making it
+    std::array<float, 32> gains = {};
+    size_t depth = 0;
+    gains[0] = board->board[target].has_value() ? see_value(board->board[target].value().piece_type) : 0.0f;
+    //en passant takes a pawn that isn't on the target square
+    if (board->en_passant.has_value() && target == board->en_passant.value()
+        && board->board[move->from].value().piece_type == Move::PieceType::Pawn) {
+        gains[0] = see_value(Move::PieceType::Pawn);
+    }
+    if (move->promotion.has_value()) {
+        gains[0] += see_value(move->promotion.value().piece_type) - see_value(Move::PieceType::Pawn);
+    }
+    Move::PieceType on_target = move->promotion.has_value()
+        ? move->promotion.value().piece_type
+        : board->board[move->from].value().piece_type;
+    lifted_indices[lifted_count] = move->from;
+    lifted_pieces[lifted_count++] = board->board[move->from];
+    board->board[move->from] = std::nullopt;
+
+    while (depth + 1 < gains.size()) {
+        side = Move::swap(side);
+        auto attackers = board->get_attackers(target, side);
+        if (attackers.empty()) {
+            break;
+        }
+        Move::Index least_valuable = *std::min_element(attackers.begin(), attackers.end(), [&](Move::Index a, Move::Index b) {
+            return see_value(board->board[a].value().piece_type) < see_value(board->board[b].value().piece_type);
+        });
+
+        depth += 1;
+        gains[depth] = see_value(on_target) - gains[depth - 1];
+        on_target = board->board[least_valuable].value().piece_type;
+        lifted_indices[lifted_count] = least_valuable;
+        lifted_pieces[lifted_count++] = board->board[least_valuable];
+        board->board[least_valuable] = std::nullopt;
+    }
+
+    for (size_t i = 0; i < lifted_count; i++) {
+        board->board[lifted_indices[i]] = lifted_pieces[i];
+    }
+
+    while (depth > 0) {
+        gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+        depth -= 1;
+    }
+    return gains[0];
 }
 
 /*
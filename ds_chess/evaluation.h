@@ -5,12 +5,77 @@
 #ifndef EVALUATION_H
 #define EVALUATION_H
 
+#include <array>
+
+#include "bitbase.h"
 #include "board.h"
+#include "material_table.h"
+#include "pawn_table.h"
 
 namespace Evaluation {
+    //value used for the king when trading off pieces in the static exchange evaluation
+    const float SEE_KING_VALUE = 100.0;
+    //endgames the bitbases know are exact: a draw scores 0, and a win this much more than its material
+    //so the search heads for it, with bonuses driving the weaker king into a mating net
+    const float KNOWN_WIN_SCORE = 50.0;
+    //per square the weaker king is pushed towards the edge, or in KBNK towards a corner of the bishop's color
+    const float KNOWN_WIN_EDGE_BONUS = 0.1;
+    //per square the kings come closer
+    const float KNOWN_WIN_KING_BONUS = 0.05;
+    //per rank a winning pawn advances
+    const float KNOWN_WIN_PAWN_BONUS = 0.1;
+
+    //game phase, counted from the pieces left beside kings and pawns
+    const int32_t KNIGHT_PHASE = 1;
+    const int32_t BISHOP_PHASE = 1;
+    const int32_t ROOK_PHASE = 2;
+    const int32_t QUEEN_PHASE = 4;
+    //the phase of the starting pieces, and the most a position is counted as
+    const int32_t MAX_PHASE = 24;
+
+    //material imbalance
+    const float BISHOP_PAIR_BONUS = 0.3;
+    //for each of their side's pawns above IMBALANCE_PAWNS knights gain and rooks lose value, and the
+    //other way around below it
+    const size_t IMBALANCE_PAWNS = 5;
+    const float KNIGHT_PAWN_ADJUSTMENT = 0.0625;
+    const float ROOK_PAWN_ADJUSTMENT = -0.125;
+
+    //pawn structure, by the pawn's rank counted from its own side
+    const std::array<float, 8> PASSED_PAWN_BONUS = {0.0, 0.1, 0.1, 0.2, 0.35, 0.6, 1.0, 0.0};
+    //share of the passed pawn bonus added again while nothing stands in front of it, weighed towards the endgame
+    const float FREE_PASSED_PAWN_FACTOR = 0.5;
+    const float ISOLATED_PAWN_PENALTY = 0.15;
+    //for each pawn with another one of its color in front of it
+    const float DOUBLED_PAWN_PENALTY = 0.15;
+    //a pawn no neighbour can defend any more, which can't advance without being taken
+    const float BACKWARD_PAWN_PENALTY = 0.1;
+    //for each pawn in the two ranks in front of a king still on its first two ranks, weighed by the game phase
+    const float PAWN_SHIELD_BONUS = 0.1;
 
-    float evaluate_board(Board::Board *board);
+    //evaluation from white's point of view
+    float evaluate_board(Board::Board *board, PawnTable::PawnTable *pawn_table, MaterialTable::MaterialTable *material_table);
+    //evaluation from the point of view of the player to move
+    float evaluate_for_current_player(
+        Board::Board *board,
+        PawnTable::PawnTable *pawn_table,
+        MaterialTable::MaterialTable *material_table
+    );
+    //material, imbalance, game phase and the endgame functions that apply, which only depend on the piece
+    //counts so they're looked up in material_table by the material key like evaluate_pawn_structure
+    MaterialTable::Entry evaluate_material(Board::Board *board, MaterialTable::MaterialTable *material_table);
+    //passed, isolated, doubled and backward pawns, which only depend on the pawns so they're looked up in
+    //pawn_table by the pawn key, and only worked out (and stored) when they're not there
+    PawnTable::Entry evaluate_pawn_structure(Board::Board *board, PawnTable::PawnTable *pawn_table);
+    //the pawn terms that also depend on the other pieces: king shields and passed pawns free to advance
+    float evaluate_pawns_with_pieces(Board::Board *board, PawnTable::Entry *pawns, int32_t phase);
+    //evaluation of a bitbase endgame from white's point of view
+    float evaluate_known_endgame(Bitbase::Probe *probe);
     float get_piece_value(Move::Piece piece);
+    float get_piece_type_value(Move::PieceType piece_type);
+    //static exchange evaluation: the material the player to move wins (or loses)
+    //from the sequence of captures on move->to, starting with move
+    float static_exchange_evaluation(Board::Board *board, Move::Move *move);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,3 +1,11 @@
+#include <cstdlib>
+#include <string>
+
+#include "bench.h"
+#include "epd.h"
+#include "pgn.h"
+#include "string_handling.h"
+#include "syzygy_check.h"
 #include "uci.h"
 
 int tui_main() {
@@ -5,6 +13,32 @@ int tui_main() {
     return 0;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    //ds_chess bench [depth]
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        Bench::bench(argc >= 3 ? atoi(argv[2]) : Bench::DEFAULT_DEPTH);
+        return 0;
+    }
+    if (argc >= 2 && (
+        std::string(argv[1]) == "epd" || std::string(argv[1]) == "analyse-pgn" || std::string(argv[1]) == "verify-syzygy"
+    )) {
+        //the rest of the command line, read the same way as the uci command
+        std::string arguments = std::string();
+        for (int i = 2; i < argc; i++) {
+            arguments += std::string(argv[i]) + " ";
+        }
+        StringHandling::Tokenizer tokens = StringHandling::Tokenizer(arguments);
+        if (std::string(argv[1]) == "epd") {
+            //ds_chess epd <file> [depth <d> | movetime <ms> | nodes <n>] [threads <n>]
+            EPD::epd_command(&tokens);
+        } else if (std::string(argv[1]) == "verify-syzygy") {
+            //ds_chess verify-syzygy <path> [samples <n>]
+            return SyzygyCheck::verify_command(&tokens) ? 0 : 1;
+        } else {
+            //ds_chess analyse-pgn <file> [depth <d> | movetime <ms> | nodes <n>] [threads <n>]
+            PGN::analyse_command(&tokens);
+        }
+        return 0;
+    }
     return tui_main();
 }
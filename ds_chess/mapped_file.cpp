@@ -0,0 +1,109 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile::MappedFile() : mapping(nullptr), length(0), file_handle(nullptr), mapping_handle(nullptr) {}
+#else
+MappedFile::MappedFile::MappedFile() : mapping(nullptr), length(0) {}
+#endif
+
+MappedFile::MappedFile::~MappedFile() {
+    this->close();
+}
+
+#ifdef _WIN32
+bool MappedFile::MappedFile::open(const std::string &path) {
+    this->close();
+    HANDLE file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    this->file_handle = file;
+    this->mapping_handle = mapping;
+    this->mapping = (const uint8_t *) view;
+    this->length = (size_t) size.QuadPart;
+    return true;
+}
+
+void MappedFile::MappedFile::close() {
+    if (this->mapping != nullptr) {
+        UnmapViewOfFile(this->mapping);
+        CloseHandle(this->mapping_handle);
+        CloseHandle(this->file_handle);
+    }
+    this->mapping = nullptr;
+    this->length = 0;
+    this->file_handle = nullptr;
+    this->mapping_handle = nullptr;
+}
+#else
+bool MappedFile::MappedFile::open(const std::string &path) {
+    this->close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+    void *view = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+    //the mapping keeps the file alive on its own
+    ::close(file);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    this->mapping = (const uint8_t *) view;
+    this->length = status.st_size;
+    return true;
+}
+
+void MappedFile::MappedFile::close() {
+    if (this->mapping != nullptr) {
+        munmap((void *) this->mapping, this->length);
+    }
+    this->mapping = nullptr;
+    this->length = 0;
+}
+#endif
+
+bool MappedFile::MappedFile::is_open() const {
+    return this->mapping != nullptr;
+}
+
+const uint8_t *MappedFile::MappedFile::data() const {
+    return this->mapping;
+}
+
+size_t MappedFile::MappedFile::size() const {
+    return this->length;
+}
@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace MappedFile {
+    //a read only file mapped into memory, so large files (opening books, tablebases) are paged in
+    //by the os as they are read rather than loaded up front, and shared between processes
+    class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        //unmaps the current file first, false if path can't be opened or mapped (an empty file can't be)
+        bool open(const std::string &path);
+        void close();
+        bool is_open() const;
+        const uint8_t *data() const;
+        size_t size() const;
+    private:
+        const uint8_t *mapping;
+        size_t length;
+#ifdef _WIN32
+        void *file_handle;
+        void *mapping_handle;
+#endif
+    };
+};
+
+#endif
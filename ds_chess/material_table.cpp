@@ -0,0 +1,32 @@
+#include "material_table.h"
+
+#include <algorithm>
+
+size_t MaterialTable::piece_count(uint64_t key, Move::Color color, Move::PieceType piece_type) {
+    return (key >> (4 * (color * 6 + piece_type))) & 0xF;
+}
+
+MaterialTable::MaterialTable::MaterialTable(size_t size) :
+    entries(std::vector<Entry>(size, Entry {}))
+{}
+
+void MaterialTable::MaterialTable::clear() {
+    std::fill(this->entries.begin(), this->entries.end(), Entry {});
+}
+
+std::optional<MaterialTable::Entry> MaterialTable::MaterialTable::probe(uint64_t key) const {
+    const Entry &entry = this->entries[this->index(key)];
+    //key 0 would be an empty board, so an empty slot never matches
+    if (entry.key != key || key == 0) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+void MaterialTable::MaterialTable::store(Entry *entry) {
+    this->entries[this->index(entry->key)] = *entry;
+}
+
+size_t MaterialTable::MaterialTable::index(uint64_t key) const {
+    return (key * 0x9E3779B97F4A7C15ULL >> 32) % this->entries.size();
+}
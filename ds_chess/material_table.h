@@ -0,0 +1,51 @@
+#ifndef MATERIAL_TABLE_H
+#define MATERIAL_TABLE_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+
+namespace MaterialTable {
+    //entries of a table, each search has its own. Only a few hundred piece counts come up in a game
+    const size_t DEFAULT_SIZE = 8192;
+
+    //evaluates a position of a specialised endgame from white's point of view, or nullopt when it
+    //can't say anything and the position is evaluated as usual
+    typedef std::optional<float> (*EvaluationFunction)(Board::Board *board);
+    //the share of the evaluation to keep, from 1 down to 0 for a dead draw
+    typedef float (*ScaleFunction)(Board::Board *board);
+
+    //what the piece counts alone say about a position
+    struct Entry {
+        //Board::material_key
+        uint64_t key;
+        //from 0 once only kings and pawns are left up to Evaluation::MAX_PHASE for the starting pieces
+        int32_t phase;
+        //material and imbalance terms from white's point of view
+        float score;
+        //replaces the evaluation, nullptr for most piece counts
+        EvaluationFunction evaluation;
+        //scales the evaluation, nullptr to keep it as it is
+        ScaleFunction scale;
+    };
+
+    //number of pieces of color and piece_type in a Board::material_key
+    size_t piece_count(uint64_t key, Move::Color color, Move::PieceType piece_type);
+
+    class MaterialTable {
+    public:
+        MaterialTable(size_t size);
+        void clear();
+        std::optional<Entry> probe(uint64_t key) const;
+        void store(Entry *entry);
+    private:
+        //the key is packed counts rather than a hash, so it's mixed before picking a slot
+        size_t index(uint64_t key) const;
+        std::vector<Entry> entries;
+    };
+};
+
+#endif
@@ -42,11 +42,19 @@ std::string Move::Piece::to_string() const {
     }
 }
 
+bool Move::Move::operator==(const Move& other) const {
+    return this->from == other.from && this->to == other.to && this->promotion == other.promotion;
+}
+
 std::string Move::Move::to_string() const {
     size_t start_rank, start_file, end_rank, end_file;
     std::tie(start_rank, start_file) = index_to_coord(this->from);
     std::tie(end_rank, end_file) = index_to_coord(this->to);
     std::string output = {(char)(start_file + 'a'), (char)(start_rank + '1'), (char)(end_file + 'a'), (char)(end_rank + '1')};
+    //uci writes the promotion piece in lowercase for both colors, as in e7e8q
+    if (this->promotion.has_value()) {
+        output += (char) tolower(this->promotion.value().to_string()[0]);
+    }
     return output;
 }
 
@@ -60,7 +68,7 @@ std::tuple<size_t, size_t> Move::Move::index_to_coord(Index index) {
     return std::make_tuple(index / 8, index % 8);
 }
 
-Move::Index Move::Move::string_to_index(std::string pos) {
+Move::Index Move::Move::string_to_index(std::string_view pos) {
     if (
         pos.length() != 2
         || !isalpha(tolower(pos[0])) || (tolower(pos[0]) < 'a' && tolower(pos[0]) > 'h')
@@ -77,16 +85,34 @@ Move::Index Move::Move::string_to_index(std::string pos) {
     return Move::coord_to_index(rank, file);
 }
 
-Move::Move Move::Move::string_to_move(std::string move) {
-    if (move.length() != 4) {
+Move::Move Move::Move::string_to_move(std::string_view move) {
+    if (move.length() != 4 && move.length() != 5) {
         throw std::invalid_argument(
-            "expected a string such as e2e4"
+            "expected a string such as e2e4 or e7e8q"
         );
     }
     Index from = string_to_index(move.substr(0, 2));
     Index to = string_to_index(move.substr(2, 2));
+    if (move.length() == 4) {
+        return Move(from, to, std::nullopt, std::nullopt);
+    }
 
-    return Move(from, to, std::nullopt, std::nullopt);
+    //only a pawn reaching the last rank promotes, which also tells whose pawn it is
+    size_t to_rank = to / 8;
+    std::optional<PieceType> piece_type = std::nullopt;
+    switch (tolower(move[4])) {
+    case 'n': piece_type = PieceType::Knight; break;
+    case 'b': piece_type = PieceType::Bishop; break;
+    case 'r': piece_type = PieceType::Rook; break;
+    case 'q': piece_type = PieceType::Queen; break;
+    }
+    if (!piece_type.has_value() || (to_rank != 0 && to_rank != 7)) {
+        throw std::invalid_argument(
+            "expected a promotion to n, b, r or q on the first or last rank"
+        );
+    }
+    Color color = to_rank == 7 ? Color::White : Color::Black;
+    return Move(from, to, std::nullopt, Piece(color, piece_type.value()));
 }
 
 std::vector<Move::Index> Move::Piece::generate_legal_moves(Board::Board *board, Index index) {
@@ -168,12 +194,10 @@ std::vector<Move::Index> Move::Piece::generate_pawn_moves(Board::Board *board, I
         size_t ep_rank, ep_file;
         std::tie(ep_rank, ep_file) = Move::index_to_coord(board->en_passant.value());
 
-        size_t abs_diff_ranks = rank > ep_rank ? rank - ep_rank : ep_rank - rank;
-        bool can_en_passant = ep_file == file && abs_diff_ranks == 1;
+        size_t abs_diff_files = file > ep_file ? file - ep_file : ep_file - file;
+        bool can_en_passant = abs_diff_files == 1 && ep_rank == (is_piece_white ? rank + 1 : rank - 1);
         if (can_en_passant) {
-            int32_t offset = dir
-                + (rank < ep_rank ? LEFT_OFFSET : RIGHT_OFFSET);
-            moves.push_back(index + offset);
+            moves.push_back(board->en_passant.value());
         }
     }
     size_t offset = index + dir;
@@ -371,8 +395,8 @@ std::vector<Move::Index> Move::Piece::generate_bishop_moves(Board::Board *board,
     f = file;
     while (true) {
         if (f > 0 && r > 0 && board->can_piece_move_to_square(i + LOWER_LEFT_OFFSET, piece.color)) {
-            std::tie(r, f) = Move::index_to_coord(i);
             i += LOWER_LEFT_OFFSET;
+            std::tie(r, f) = Move::index_to_coord(i);
             moves.push_back(i);
             if (board->is_piece_capturable(i, piece.color)) {
                 break;
@@ -445,8 +469,8 @@ std::vector<Move::Index> Move::Piece::generate_bishop_capture_moves(Board::Board
     f = file;
     while (true) {
         if (f > 0 && r > 0 && board->can_piece_move_to_square(i + LOWER_LEFT_OFFSET, piece.color)) {
-            std::tie(r, f) = Move::index_to_coord(i);
             i += LOWER_LEFT_OFFSET;
+            std::tie(r, f) = Move::index_to_coord(i);
             if (board->is_piece_capturable(i, piece.color)) {
                 moves.push_back(i);
                 break;
@@ -519,8 +543,8 @@ std::vector<Move::Index> Move::Piece::generate_rook_moves(Board::Board *board, I
     f = file;
     while (true) {
         if (r > 0 && board->can_piece_move_to_square(i + DOWN_OFFSET, piece.color)) {
+            i += DOWN_OFFSET;
             std::tie(r, f) = Move::index_to_coord(i);
-            i += LOWER_LEFT_OFFSET;
             moves.push_back(i);
             if (board->is_piece_capturable(i, piece.color)) {
                 break;
@@ -593,8 +617,8 @@ std::vector<Move::Index> Move::Piece::generate_rook_capture_moves(Board::Board *
     f = file;
     while (true) {
         if (r > 0 && board->can_piece_move_to_square(i + DOWN_OFFSET, piece.color)) {
+            i += DOWN_OFFSET;
             std::tie(r, f) = Move::index_to_coord(i);
-            i += LOWER_LEFT_OFFSET;
             if (board->is_piece_capturable(i, piece.color)) {
                 moves.push_back(i);
                 break;
@@ -712,8 +736,8 @@ std::vector<Move::Index> Move::Piece::generate_queen_moves(Board::Board *board,
     f = file;
     while (true) {
         if (r > 0 && board->can_piece_move_to_square(i + DOWN_OFFSET, piece.color)) {
-            std::tie(r, f) = Move::index_to_coord(i);
             i += DOWN_OFFSET;
+            std::tie(r, f) = Move::index_to_coord(i);
             moves.push_back(i);
             if (board->is_piece_capturable(i, piece.color)) {
                 break;
@@ -727,8 +751,8 @@ std::vector<Move::Index> Move::Piece::generate_queen_moves(Board::Board *board,
     f = file;
     while (true) {
         if (f > 0 && r > 0 && board->can_piece_move_to_square(i + LOWER_LEFT_OFFSET, piece.color)) {
-            std::tie(r, f) = Move::index_to_coord(i);
             i += LOWER_LEFT_OFFSET;
+            std::tie(r, f) = Move::index_to_coord(i);
             moves.push_back(i);
             if (board->is_piece_capturable(i, piece.color)) {
                 break;
@@ -846,8 +870,8 @@ std::vector<Move::Index> Move::Piece::generate_queen_capture_moves(Board::Board
     f = file;
     while (true) {
         if (r > 0 && board->can_piece_move_to_square(i + DOWN_OFFSET, piece.color)) {
-            std::tie(r, f) = Move::index_to_coord(i);
             i += DOWN_OFFSET;
+            std::tie(r, f) = Move::index_to_coord(i);
             if (board->is_piece_capturable(i, piece.color)) {
                 moves.push_back(i);
                 break;
@@ -861,8 +885,8 @@ std::vector<Move::Index> Move::Piece::generate_queen_capture_moves(Board::Board
     f = file;
     while (true) {
         if (f > 0 && r > 0 && board->can_piece_move_to_square(i + LOWER_LEFT_OFFSET, piece.color)) {
-            std::tie(r, f) = Move::index_to_coord(i);
             i += LOWER_LEFT_OFFSET;
+            std::tie(r, f) = Move::index_to_coord(i);
             if (board->is_piece_capturable(i, piece.color)) {
                 moves.push_back(i);
                 break;
@@ -890,11 +914,11 @@ std::vector<Move::Index> Move::Piece::generate_king_moves(Board::Board *board, I
         moves.push_back(offset);
     }
     offset = index + UPPER_LEFT_OFFSET;
-    if (rank < 7 && file < 0 && board->can_piece_move_to_square(offset, piece.color)) {
+    if (rank < 7 && file > 0 && board->can_piece_move_to_square(offset, piece.color)) {
         moves.push_back(offset);
     }
     offset = index + UP_OFFSET;
-    if (rank > 7 && board->can_piece_move_to_square(offset, piece.color)) {
+    if (rank < 7 && board->can_piece_move_to_square(offset, piece.color)) {
         moves.push_back(offset);
     }
     offset = index + UPPER_RIGHT_OFFSET;
@@ -927,7 +951,8 @@ std::vector<Move::Index> Move::Piece::generate_king_moves(Board::Board *board, I
         && !board->board[rook_index + 1].has_value()
         && !board->board[rook_index + 2].has_value()
         && !board->board[rook_index + 3].has_value()
-        //TODO check if traversed square is attacked
+        && !board->is_in_check(piece.color)
+        && !board->is_square_attacked(Board::Board::get_default_king_for_color(piece.color) - 1, swap(piece.color))
     ) {
         moves.push_back(Board::Board::get_default_king_for_color(piece.color) - 2);
     }
@@ -936,11 +961,12 @@ std::vector<Move::Index> Move::Piece::generate_king_moves(Board::Board *board, I
     if (
         board->get_kingside_castle_for_color(piece.color)
         && board->board[rook_index].has_value()
-        && board->board[rook_index].value().color <= piece.color
+        && board->board[rook_index].value().color == piece.color
         && board->board[rook_index].value().piece_type == PieceType::Rook
         && !board->board[rook_index - 1].has_value()
         && !board->board[rook_index - 2].has_value()
-        //TODO check if traversed square is attacked
+        && !board->is_in_check(piece.color)
+        && !board->is_square_attacked(Board::Board::get_default_king_for_color(piece.color) + 1, swap(piece.color))
     ) {
         moves.push_back(Board::Board::get_default_king_for_color(piece.color) + 2);
     }
@@ -963,11 +989,11 @@ std::vector<Move::Index> Move::Piece::generate_king_capture_moves(Board::Board *
         moves.push_back(offset);
     }
     offset = index + UPPER_LEFT_OFFSET;
-    if (rank < 7 && file < 0 && board->is_piece_capturable(offset, piece.color)) {
+    if (rank < 7 && file > 0 && board->is_piece_capturable(offset, piece.color)) {
         moves.push_back(offset);
     }
     offset = index + UP_OFFSET;
-    if (rank > 7 && board->is_piece_capturable(offset, piece.color)) {
+    if (rank < 7 && board->is_piece_capturable(offset, piece.color)) {
         moves.push_back(offset);
     }
     offset = index + UPPER_RIGHT_OFFSET;
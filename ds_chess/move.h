@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 //#include "board.h"
@@ -71,15 +72,27 @@ namespace Move {
         std::optional<Piece> capture;
         std::optional<Piece> promotion;
         CastlingRights lost_castling_rights;
+        //state make_move overwrites, kept so unmake_move can restore it
+        std::optional<size_t> previous_en_passant;
+        size_t previous_moves_since_last_pawn_move_or_capture;
+        uint64_t previous_key;
+        uint64_t previous_pawn_key;
+        uint64_t previous_material_key;
 
         Move(Index from, Index to, std::optional<Piece> capture, std::optional<Piece> promotion)
-            : from(from), to(to), capture(capture), promotion(promotion) {}
+            : from(from), to(to), capture(capture), promotion(promotion), lost_castling_rights(CastlingRights::None),
+            previous_en_passant(std::nullopt), previous_moves_since_last_pawn_move_or_capture(0),
+            previous_key(0), previous_pawn_key(0), previous_material_key(0) {}
+        //compares the squares and promotion, not the state saved by make_move
+        bool operator==(const Move& other) const;
+        //long algebraic notation as used by uci, such as e2e4 or e7e8q
         std::string to_string() const;
         static Index coord_to_index(size_t rank, size_t file);
         //returns tuple of the form (rank, file)
         static std::tuple<size_t, size_t> index_to_coord(Index index);
-        static Index string_to_index(std::string pos);
-        static Move string_to_move(std::string move);
+        static Index string_to_index(std::string_view pos);
+        //reads to_string's notation, throws std::invalid_argument if move isn't written that way
+        static Move string_to_move(std::string_view move);
     };
 
     Color swap(Color color);
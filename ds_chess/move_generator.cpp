@@ -17,7 +17,7 @@ std::vector<Move::Move> MoveGenerator::generate_moves(Board::Board *board) {
         std::vector<Move::Move> moves_for_piece = {};
         size_t last_rank = piece.color == Move::Color::White ? 7 : 0;
         for (Move::Index index_for_piece : Move::Piece::generate_legal_moves(board, i)) {
-            if (piece.piece_type == Move::PieceType::Pawn && std::get<1>(Move::Move::index_to_coord(i)) == last_rank) {
+            if (piece.piece_type == Move::PieceType::Pawn && std::get<0>(Move::Move::index_to_coord(index_for_piece)) == last_rank) {
                 moves_for_piece.push_back(Move::Move(i, index_for_piece, {}, Move::Piece(piece.color, Move::PieceType::Knight)));
                 moves_for_piece.push_back(Move::Move(i, index_for_piece, {}, Move::Piece(piece.color, Move::PieceType::Bishop)));
                 moves_for_piece.push_back(Move::Move(i, index_for_piece, {}, Move::Piece(piece.color, Move::PieceType::Rook)));
@@ -47,7 +47,7 @@ std::vector<Move::Move> MoveGenerator::generate_capture_moves(Board::Board *boar
         std::vector<Move::Move> moves_for_piece = {};
         size_t last_rank = piece.color == Move::Color::White ? 7 : 0;
         for (Move::Index index_for_piece : Move::Piece::generate_capture_moves(board, i)) {
-            if (piece.piece_type == Move::PieceType::Pawn && std::get<1>(Move::Move::index_to_coord(i)) == last_rank) {
+            if (piece.piece_type == Move::PieceType::Pawn && std::get<0>(Move::Move::index_to_coord(index_for_piece)) == last_rank) {
                 moves_for_piece.push_back(Move::Move(i, index_for_piece, {}, Move::Piece(piece.color, Move::PieceType::Knight)));
                 moves_for_piece.push_back(Move::Move(i, index_for_piece, {}, Move::Piece(piece.color, Move::PieceType::Bishop)));
                 moves_for_piece.push_back(Move::Move(i, index_for_piece, {}, Move::Piece(piece.color, Move::PieceType::Rook)));
@@ -0,0 +1,24 @@
+#include "pawn_table.h"
+
+#include <algorithm>
+
+PawnTable::PawnTable::PawnTable(size_t size) :
+    entries(std::vector<Entry>(size, Entry {}))
+{}
+
+void PawnTable::PawnTable::clear() {
+    std::fill(this->entries.begin(), this->entries.end(), Entry {});
+}
+
+std::optional<PawnTable::Entry> PawnTable::PawnTable::probe(uint64_t key) const {
+    const Entry &entry = this->entries[key % this->entries.size()];
+    if (entry.key != key) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+void PawnTable::PawnTable::store(Entry *entry) {
+    //always replace, the structures met last are the ones the search comes back to
+    this->entries[entry->key % this->entries.size()] = *entry;
+}
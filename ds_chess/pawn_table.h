@@ -0,0 +1,41 @@
+#ifndef PAWN_TABLE_H
+#define PAWN_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace PawnTable {
+    //entries of a table, each search has its own and the pawns change rarely enough that this holds
+    //nearly every structure it meets
+    const size_t DEFAULT_SIZE = 16384;
+
+    //what the pawns alone say about a position. Bitboards have bit rank * 8 + file set and are
+    //indexed by Move::Color
+    struct Entry {
+        //Board::pawn_key
+        uint64_t key;
+        //the pawn structure terms from white's point of view
+        float score;
+        std::array<uint64_t, 2> pawns;
+        std::array<uint64_t, 2> passed_pawns;
+        //squares the pawns attack
+        std::array<uint64_t, 2> attacks;
+        //squares the pawns attack or could attack by advancing
+        std::array<uint64_t, 2> attack_spans;
+    };
+
+    class PawnTable {
+    public:
+        PawnTable(size_t size);
+        void clear();
+        //an empty table holds the entry of no pawns at all, which has key 0 and nothing else either
+        std::optional<Entry> probe(uint64_t key) const;
+        void store(Entry *entry);
+    private:
+        std::vector<Entry> entries;
+    };
+};
+
+#endif
@@ -0,0 +1,343 @@
+#include "pgn.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+#include "bitbase.h"
+#include "material_table.h"
+#include "pawn_table.h"
+#include "san.h"
+#include "transposition_table.h"
+
+static bool is_symbol_char(int c) {
+    return std::isalnum(c) || c == '+' || c == '#' || c == '=' || c == '-' || c == '/' || c == ':'
+        || c == '!' || c == '?' || c == '*' || c == '.' || c == '_';
+}
+
+static bool is_result(std::string_view symbol) {
+    return symbol == "1-0" || symbol == "0-1" || symbol == "1/2-1/2" || symbol == "*";
+}
+
+PGN::Reader::Reader(std::istream *input) : input(input) {}
+
+bool PGN::Reader::skip_to_token() {
+    while (true) {
+        int c = this->input->peek();
+        if (c == EOF) {
+            return false;
+        } else if (std::isspace(c)) {
+            this->input->get();
+        } else if (c == '{') {
+            this->input->ignore(std::numeric_limits<std::streamsize>::max(), '}');
+        } else if (c == ';' || c == '%') {
+            this->input->ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        } else {
+            return true;
+        }
+    }
+}
+
+void PGN::Reader::read_tag(Game *game) {
+    Tag tag = Tag();
+    this->input->get();
+    int c = this->input->peek();
+    while (c != EOF && (std::isalnum(c) || c == '_')) {
+        tag.name += (char) this->input->get();
+        c = this->input->peek();
+    }
+    while (c != EOF && c != '"' && c != ']' && c != '\n') {
+        this->input->get();
+        c = this->input->peek();
+    }
+    if (c == '"') {
+        this->input->get();
+        for (c = this->input->get(); c != EOF && c != '"' && c != '\n'; c = this->input->get()) {
+            if (c == '\\') {
+                c = this->input->get();
+            }
+            tag.value += (char) c;
+        }
+    }
+    //whatever is left of the tag, up to the closing bracket
+    while (c != EOF && c != ']' && c != '\n') {
+        c = this->input->get();
+    }
+    game->tags.push_back(tag);
+}
+
+std::string PGN::Reader::read_symbol() {
+    std::string symbol = std::string();
+    while (is_symbol_char(this->input->peek())) {
+        symbol += (char) this->input->get();
+    }
+    return symbol;
+}
+
+bool PGN::Reader::next_game(Game *game) {
+    *game = Game {std::vector<Tag>(), Board::STARTPOS, std::vector<Move::Move>(), std::vector<std::string>(), "*", false};
+    Board::Board board = Board::Board();
+    bool started = false;
+    bool in_moves = false;
+    while (this->skip_to_token()) {
+        int c = this->input->peek();
+        if (c == '[') {
+            //the tags of the next game, this one ended without a result
+            if (in_moves) {
+                return true;
+            }
+            this->read_tag(game);
+            started = true;
+            continue;
+        }
+
+        if (!in_moves) {
+            for (Tag &tag : game->tags) {
+                if (tag.name == "FEN") {
+                    game->start_fen = tag.value;
+                }
+            }
+            game->truncated = std::holds_alternative<Board::FenError>(board.set_fen(game->start_fen));
+            in_moves = true;
+            started = true;
+        }
+
+        if (c == '(') {
+            //variations may nest and contain comments
+            size_t depth = 0;
+            do {
+                c = this->input->get();
+                if (c == '(') {
+                    depth += 1;
+                } else if (c == ')') {
+                    depth -= 1;
+                } else if (c == '{') {
+                    this->input->ignore(std::numeric_limits<std::streamsize>::max(), '}');
+                }
+            } while (c != EOF && depth > 0);
+            continue;
+        } else if (c == '$') {
+            //numeric annotation glyph
+            this->input->get();
+            this->read_symbol();
+            continue;
+        }
+
+        std::string symbol = this->read_symbol();
+        if (symbol.empty()) {
+            //stray character
+            this->input->get();
+            continue;
+        }
+        if (is_result(symbol)) {
+            game->result = symbol;
+            return true;
+        }
+        //move numbers, which may run into the move (1.e4) and are followed by three dots before a black move
+        size_t digits = 0;
+        while (digits < symbol.size() && std::isdigit(symbol[digits])) {
+            digits += 1;
+        }
+        if (digits > 0 && (digits == symbol.size() || symbol[digits] == '.')) {
+            size_t dots = symbol.find_first_not_of('.', digits);
+            symbol = dots == std::string::npos ? std::string() : symbol.substr(dots);
+        }
+        if (symbol.empty() || game->truncated) {
+            continue;
+        }
+
+        std::optional<Move::Move> move = SAN::from_san(&board, symbol);
+        if (!move.has_value()) {
+            game->truncated = true;
+            continue;
+        }
+        game->moves.push_back(move.value());
+        game->san.push_back(symbol);
+        board.make_move(&move.value());
+    }
+    return started;
+}
+
+//pawns, from white's point of view, or a mate in moves (#3, #-2)
+static std::string format_score(float score) {
+    std::ostringstream out = std::ostringstream();
+    if (Search::is_mate_score(score)) {
+        int32_t plies = (int32_t) (Search::MATE_SCORE - std::abs(score));
+        out << "#" << (score > 0 ? (plies + 1) / 2 : -((plies + 1) / 2));
+    } else {
+        //adding zero turns -0.00 into +0.00
+        out << std::showpos << std::fixed << std::setprecision(2) << std::round(score * 100.0f) / 100.0f + 0.0f;
+    }
+    return out.str();
+}
+
+static std::string analyse_game(
+    PGN::Game *game,
+    Search::SearchLimits *limits,
+    TimeManager::TimeControl time_control,
+    TranspositionTable::TranspositionTable *transposition_table,
+    PawnTable::PawnTable *pawn_table,
+    MaterialTable::MaterialTable *material_table
+) {
+    std::ostringstream out = std::ostringstream();
+    for (PGN::Tag &tag : game->tags) {
+        out << "[" << tag.name << " \"";
+        for (char c : tag.value) {
+            out << (c == '"' || c == '\\' ? "\\" : "") << c;
+        }
+        out << "\"]\n";
+    }
+    out << "[Annotator \"ds_chess\"]\n\n";
+
+    Board::Board board = Board::Board();
+    if (std::holds_alternative<Board::FenError>(board.set_fen(game->start_fen))) {
+        out << "{invalid fen} " << game->result << "\n\n";
+        return out.str();
+    }
+    //positions of the same game share a lot, so the table is only cleared between games
+    transposition_table->clear();
+
+    //the comment after each move is about the position it leads to, the first one about the starting position
+    for (size_t i = 0; i <= game->moves.size(); i++) {
+        if (i > 0) {
+            Move::Move move = game->moves[i - 1];
+            if (board.current_player == Move::Color::White) {
+                out << board.num_moves << ". ";
+            } else if (i == 1) {
+                out << board.num_moves << "... ";
+            }
+            out << game->san[i - 1] << " ";
+            board.make_move(&move);
+        }
+
+        TimeManager::TimeManager time_manager = TimeManager::TimeManager(time_control);
+        Search::SearchResult result = Search::init_search(limits, &board, &time_manager, transposition_table, pawn_table, material_table);
+        //checkmate or stalemate
+        if (result.pv.empty()) {
+            continue;
+        }
+        float score = board.current_player == Move::Color::White ? result.score : -result.score;
+        out << "{" << format_score(score);
+        if (!result.iterations.empty()) {
+            out << "/" << result.iterations.back().depth;
+        }
+        out << " " << SAN::to_san(&board, &result.pv[0]) << "} ";
+    }
+    if (game->truncated) {
+        out << "{unreadable move} ";
+    }
+    out << game->result << "\n\n";
+    return out.str();
+}
+
+void PGN::analyse_command(StringHandling::Tokenizer *tokens) {
+    std::string path = std::string(tokens->next());
+    Search::SearchLimits limits = Search::SearchLimits();
+    limits.silent = true;
+    TimeManager::TimeControl time_control = TimeManager::TimeControl();
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool limited = false;
+    while (tokens->has_next()) {
+        std::string_view token = tokens->next();
+        if (token == "depth") {
+            limits.depth = StringHandling::to_int(tokens->next());
+            limited = true;
+        } else if (token == "movetime") {
+            time_control.move_time = StringHandling::to_int(tokens->next());
+            limited = true;
+        } else if (token == "nodes") {
+            limits.nodes = std::max<int64_t>(0, StringHandling::to_int(tokens->next()));
+            limited = true;
+        } else if (token == "threads") {
+            threads = std::max<int64_t>(1, StringHandling::to_int(tokens->next()));
+        }
+    }
+    if (!limited) {
+        limits.depth = DEFAULT_DEPTH;
+    }
+
+    std::ifstream file = std::ifstream(path);
+    if (!file.is_open()) {
+        std::cout << "could not open " << path << std::endl;
+        return;
+    }
+    analyse(&file, limits, time_control, threads);
+}
+
+void PGN::analyse(
+    std::istream *input,
+    Search::SearchLimits limits,
+    TimeManager::TimeControl time_control,
+    size_t threads
+) {
+    //the bitbases change how endgames are evaluated, so they're complete before any game is analysed
+    Bitbase::init(threads);
+
+    //games waiting for a worker, the reader blocks while it is full
+    std::queue<Game> games = std::queue<Game>();
+    bool finished_reading = false;
+    std::mutex queue_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::mutex output_mutex;
+    size_t capacity = threads * GAMES_PER_THREAD;
+
+    //games are printed as they are finished, which is not necessarily the order they were read in
+    auto worker = [&]() {
+        Search::SearchLimits worker_limits = limits;
+        TranspositionTable::TranspositionTable transposition_table = TranspositionTable::TranspositionTable(
+            TranspositionTable::DEFAULT_SIZE_MB
+        );
+        PawnTable::PawnTable pawn_table = PawnTable::PawnTable(PawnTable::DEFAULT_SIZE);
+        MaterialTable::MaterialTable material_table = MaterialTable::MaterialTable(MaterialTable::DEFAULT_SIZE);
+        while (true) {
+            Game game;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                not_empty.wait(lock, [&]() { return !games.empty() || finished_reading; });
+                if (games.empty()) {
+                    return;
+                }
+                game = std::move(games.front());
+                games.pop();
+            }
+            not_full.notify_one();
+
+            std::string annotated = analyse_game(&game, &worker_limits, time_control, &transposition_table, &pawn_table, &material_table);
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << annotated << std::flush;
+        }
+    };
+
+    std::vector<std::thread> workers = std::vector<std::thread>();
+    for (size_t i = 0; i < threads; i++) {
+        workers.push_back(std::thread(worker));
+    }
+
+    Reader reader = Reader(input);
+    Game game;
+    while (reader.next_game(&game)) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        not_full.wait(lock, [&]() { return games.size() < capacity; });
+        games.push(std::move(game));
+        not_empty.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        finished_reading = true;
+    }
+    not_empty.notify_all();
+
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <istream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+#include "search.h"
+#include "string_handling.h"
+#include "time_manager.h"
+
+//portable game notation: tag pairs followed by the moves in standard algebraic notation
+namespace PGN {
+    //used when the command gives no depth, movetime or nodes
+    const int32_t DEFAULT_DEPTH = 6;
+    //games read ahead of the analysis per thread, which is all that is ever held in memory
+    const size_t GAMES_PER_THREAD = 2;
+
+    struct Tag {
+        std::string name;
+        std::string value;
+    };
+
+    struct Game {
+        std::vector<Tag> tags;
+        //from the FEN tag, or the standard starting position
+        std::string start_fen;
+        std::vector<Move::Move> moves;
+        //the moves as written in the file
+        std::vector<std::string> san;
+        //1-0, 0-1, 1/2-1/2 or *
+        std::string result;
+        //a move could not be decoded (or the FEN tag was invalid), moves stops before it
+        bool truncated;
+    };
+
+    //reads one game at a time from a stream, so memory use depends on the longest game rather than the file,
+    //comments, variations and numeric annotations are skipped
+    class Reader {
+    public:
+        Reader(std::istream *input);
+        //false once there are no games left
+        bool next_game(Game *game);
+    private:
+        std::istream *input;
+
+        //skips whitespace, comments and escaped lines, false at the end of the input
+        bool skip_to_token();
+        void read_tag(Game *game);
+        //a move, move number or result
+        std::string read_symbol();
+    };
+
+    //analyse-pgn <file> [depth <d> | movetime <ms> | nodes <n>] [threads <n>]
+    void analyse_command(StringHandling::Tokenizer *tokens);
+    //searches every position of every game, analysing games in parallel while the reader streams in the next ones,
+    //and prints each game with the score and best move as a comment after every move
+    void analyse(
+        std::istream *input,
+        Search::SearchLimits limits,
+        TimeManager::TimeControl time_control,
+        size_t threads
+    );
+};
+
+#endif
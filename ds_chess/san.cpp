@@ -0,0 +1,220 @@
+#include "san.h"
+
+#include <vector>
+
+#include "move_generator.h"
+
+static std::optional<Move::PieceType> piece_type_from_san(char c) {
+    switch (c) {
+    case 'N': return Move::PieceType::Knight;
+    case 'B': return Move::PieceType::Bishop;
+    case 'R': return Move::PieceType::Rook;
+    case 'Q': return Move::PieceType::Queen;
+    case 'K': return Move::PieceType::King;
+    default: return std::nullopt;
+    }
+}
+
+static char piece_type_to_san(Move::PieceType piece_type) {
+    switch (piece_type) {
+    case Move::PieceType::Knight: return 'N';
+    case Move::PieceType::Bishop: return 'B';
+    case Move::PieceType::Rook: return 'R';
+    case Move::PieceType::Queen: return 'Q';
+    case Move::PieceType::King: return 'K';
+    default: return 'P';
+    }
+}
+
+static bool is_legal(Board::Board *board, Move::Move *move) {
+    return std::holds_alternative<Board::SuccessfulOperation>(board->is_valid_move(move));
+}
+
+//the squares a piece of the moving player's piece_type could move to `to` from: its attackers for pieces
+//and pawn captures, the squares behind it for pawn pushes. Not all of them are legal moves
+static std::vector<Move::Index> candidate_origins(
+    Board::Board *board, Move::Index to, Move::PieceType piece_type, bool pawn_push
+) {
+    Move::Color color = board->current_player;
+    std::vector<Move::Index> origins = std::vector<Move::Index>();
+    auto is_own = [board, color, piece_type](int32_t i) {
+        return i >= 0 && i < 64 && board->board[i].has_value()
+            && board->board[i].value().color == color && board->board[i].value().piece_type == piece_type;
+    };
+    if (piece_type == Move::PieceType::Pawn && pawn_push) {
+        int32_t behind = color == Move::Color::White ? Move::DOWN_OFFSET : Move::UP_OFFSET;
+        int32_t one = (int32_t) to + behind;
+        int32_t two = one + behind;
+        if (is_own(one)) {
+            origins.push_back(one);
+        } else if (one >= 0 && one < 64 && !board->board[one].has_value() && is_own(two)) {
+            origins.push_back(two);
+        }
+        return origins;
+    }
+    //attacks are found from the geometry alone, so this includes a pawn capturing en passant onto an empty square
+    for (Move::Index from : board->get_attackers(to, color)) {
+        if (is_own(from)) {
+            origins.push_back(from);
+        }
+    }
+    return origins;
+}
+
+std::optional<Move::Move> SAN::from_san(Board::Board *board, std::string_view san) {
+    //check, mate and annotation suffixes don't help find the move
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.remove_suffix(1);
+    }
+
+    Move::Color color = board->current_player;
+    Move::Index king = Board::Board::get_default_king_for_color(color);
+
+    //castling, also accepted with zeros
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        Move::Move move = Move::Move(king, san.size() == 3 ? king + 2 : king - 2, std::nullopt, std::nullopt);
+        std::optional<Move::Piece> piece = board->board[king];
+        if (piece.has_value() && piece.value().piece_type == Move::PieceType::King && is_legal(board, &move)) {
+            return move;
+        }
+        return std::nullopt;
+    }
+
+    Move::PieceType piece_type = Move::PieceType::Pawn;
+    std::optional<Move::PieceType> promotion = std::nullopt;
+    if (!san.empty() && piece_type_from_san(san.front()).has_value()) {
+        piece_type = piece_type_from_san(san.front()).value();
+        san.remove_prefix(1);
+    }
+    //promotions are written e8=Q, though e8Q is common as well
+    if (piece_type == Move::PieceType::Pawn && !san.empty() && piece_type_from_san(san.back()).has_value()) {
+        promotion = piece_type_from_san(san.back());
+        san.remove_suffix(1);
+        if (!san.empty() && san.back() == '=') {
+            san.remove_suffix(1);
+        }
+    }
+
+    //the destination square comes last, anything before it is a capture mark or disambiguation
+    if (san.size() < 2 || san[san.size() - 2] < 'a' || san[san.size() - 2] > 'h'
+        || san.back() < '1' || san.back() > '8') {
+        return std::nullopt;
+    }
+    Move::Index to = Move::Move::coord_to_index(san.back() - '1', san[san.size() - 2] - 'a');
+    san.remove_suffix(2);
+    std::optional<size_t> from_file = std::nullopt;
+    std::optional<size_t> from_rank = std::nullopt;
+    for (char c : san) {
+        if (c >= 'a' && c <= 'h') {
+            from_file = c - 'a';
+        } else if (c >= '1' && c <= '8') {
+            from_rank = c - '1';
+        } else if (c != 'x' && c != ':' && c != '-') {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<Move::Piece> promotion_piece = std::nullopt;
+    if (piece_type == Move::PieceType::Pawn && (to / 8 == 0 || to / 8 == 7)) {
+        promotion_piece = Move::Piece(color, promotion.value_or(Move::PieceType::Queen));
+    } else if (promotion.has_value()) {
+        return std::nullopt;
+    }
+
+    //a pawn only changes file when capturing, which is always written with the file it came from
+    bool pawn_push = !from_file.has_value() || from_file.value() == to % 8;
+    std::optional<Move::Move> found = std::nullopt;
+    for (Move::Index from : candidate_origins(board, to, piece_type, pawn_push)) {
+        if ((from_file.has_value() && from % 8 != from_file.value())
+            || (from_rank.has_value() && from / 8 != from_rank.value())) {
+            continue;
+        }
+        Move::Move move = Move::Move(from, to, std::nullopt, promotion_piece);
+        if (!is_legal(board, &move)) {
+            continue;
+        }
+        if (found.has_value()) {
+            return std::nullopt;
+        }
+        found = move;
+    }
+    return found;
+}
+
+std::string SAN::to_san(Board::Board *board, Move::Move *move) {
+    Move::Piece piece = board->board[move->from].value();
+    std::string san = std::string();
+
+    size_t from_file = move->from % 8;
+    size_t to_file = move->to % 8;
+    if (piece.piece_type == Move::PieceType::King && (from_file + 2 == to_file || to_file + 2 == from_file)) {
+        san = to_file > from_file ? "O-O" : "O-O-O";
+    } else {
+        bool is_capture = board->board[move->to].has_value()
+            || (piece.piece_type == Move::PieceType::Pawn && from_file != to_file);
+        if (piece.piece_type == Move::PieceType::Pawn) {
+            if (is_capture) {
+                san += (char) ('a' + from_file);
+            }
+        } else {
+            san += piece_type_to_san(piece.piece_type);
+            //other pieces of the same type that can legally move to the same square
+            bool shares_file = false;
+            bool shares_rank = false;
+            bool ambiguous = false;
+            if (piece.piece_type != Move::PieceType::King) {
+                for (Move::Index other : candidate_origins(board, move->to, piece.piece_type, false)) {
+                    Move::Move other_move = Move::Move(other, move->to, std::nullopt, std::nullopt);
+                    if (other == move->from || !is_legal(board, &other_move)) {
+                        continue;
+                    }
+                    ambiguous = true;
+                    shares_file = shares_file || other % 8 == from_file;
+                    shares_rank = shares_rank || other / 8 == move->from / 8;
+                }
+            }
+            //the file if it tells them apart, else the rank, else both
+            if (ambiguous && (!shares_file || shares_rank)) {
+                san += (char) ('a' + from_file);
+            }
+            if (ambiguous && shares_file) {
+                san += (char) ('1' + move->from / 8);
+            }
+        }
+        if (is_capture) {
+            san += 'x';
+        }
+        san += (char) ('a' + to_file);
+        san += (char) ('1' + move->to / 8);
+        if (move->promotion.has_value()) {
+            san += '=';
+            san += piece_type_to_san(move->promotion.value().piece_type);
+        }
+    }
+
+    //only a move that gives check needs the replies generated, to tell check from mate
+    Move::Move played = *move;
+    board->make_move(&played);
+    if (board->is_in_check(board->current_player)) {
+        san += MoveGenerator::generate_moves(board).empty() ? '#' : '+';
+    }
+    board->unmake_move(&played);
+    return san;
+}
+
+std::string SAN::line_to_san(Board::Board *board, std::vector<Move::Move> *line) {
+    std::string san = std::string();
+    std::vector<Move::Move> played = std::vector<Move::Move>();
+    for (Move::Move &move : *line) {
+        if (!played.empty()) {
+            san += ' ';
+        }
+        san += to_san(board, &move);
+        played.push_back(move);
+        board->make_move(&played.back());
+    }
+    for (auto it = played.rbegin(); it != played.rend(); it++) {
+        board->unmake_move(&*it);
+    }
+    return san;
+}
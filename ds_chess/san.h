@@ -0,0 +1,24 @@
+#ifndef SAN_H
+#define SAN_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+
+//standard algebraic notation, as used by pgn and epd.
+//both directions only look at the pieces attacking the destination square rather than generating every legal move
+namespace SAN {
+    //finds the legal move written as san (such as Nbd7, exd6, e8=Q+ or O-O) in the position,
+    //nullopt if there is no such move or it is ambiguous. A pawn reaching the last rank without a piece promotes to a queen
+    std::optional<Move::Move> from_san(Board::Board *board, std::string_view san);
+    //move has to be legal in the position
+    std::string to_san(Board::Board *board, Move::Move *move);
+    //the moves of a line, each in the position the ones before it lead to, leaving board as it was
+    std::string line_to_san(Board::Board *board, std::vector<Move::Move> *line);
+};
+
+#endif
@@ -4,72 +4,711 @@
 
 #include "search.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <vector>
 #include <string>
 #include <optional>
+#include <utility>
+#include "evaluation.h"
 #include "move_generator.h"
+#include "syzygy.h"
+#include "trace.h"
 
-float Search::search(int32_t depth, Board::Board* board) {
+float Search::search(int32_t depth, int32_t ply, float alpha, float beta, Board::Board* board, SearchState *state) {
 
-    if (depth == 0) {
-        //check for checkmate and/or draw
+    if (depth <= 0) {
+        return quiescence(ply, alpha, beta, board, state);
+    }
+    state->nodes += 1;
+    state->pv[ply].clear();
+    check_time(state);
+    if (state->stopped) {
         return 0.0;
     }
+    if (ply >= MAX_PLY) {
+        return Evaluation::evaluate_for_current_player(board, state->pawn_table, state->material_table);
+    }
+    //checked before the transposition table, whose entries don't know how the position was reached
+    if (board->is_draw(ply)) {
+        return DRAW_SCORE;
+    }
 
-    /*
+    //mate distance pruning: even mating right away can't beat a shorter mate found elsewhere
+    alpha = std::max(alpha, -MATE_SCORE + ply);
+    beta = std::min(beta, MATE_SCORE - ply - 1);
+    if (alpha >= beta) {
+        return alpha;
+    }
 
-    have a vector moves = movegenerator::generate_moves
-    float bestEval = -numeric_limits::infinity();
-    for (Move move : moves) {
-        board.make_move(move);
-        float eval = search(depth -1, board);
-        board.unmake_move(move);
-        if eval > bestEval {
-            bestEval = eval;
+    bool is_pv_node = beta - alpha > NULL_WINDOW;
+    if (is_pv_node) {
+        SEARCH_STAT(state, pv_nodes);
+    } else {
+        SEARCH_STAT(state, non_pv_nodes);
+    }
+    bool in_check = board->is_in_check(board->current_player);
+    float original_alpha = alpha;
+
+    //the singular extension search looks at the same position without one move, so its
+    //results must neither come from nor go into the transposition table
+    std::optional<Move::Move> excluded_move = state->excluded_moves[ply];
+    std::optional<TranspositionTable::Entry> tt_entry = std::nullopt;
+    std::optional<Move::Move> tt_move = std::nullopt;
+    if (!excluded_move.has_value()) {
+        SEARCH_STAT(state, tt_probes);
+        tt_entry = state->transposition_table->probe(board->key);
+    }
+    if (tt_entry.has_value()) {
+        SEARCH_STAT(state, tt_hits);
+        tt_entry.value().score = score_from_tt(tt_entry.value().score, ply);
+        tt_move = TranspositionTable::unpack_move(tt_entry.value().move, board->current_player);
+        if (!is_pv_node && is_tt_cutoff(&tt_entry.value(), depth, alpha, beta)) {
+            SEARCH_STAT(state, tt_cutoffs);
+            return tt_entry.value().score;
+        }
+    }
+
+    //tablebases, probed right after a capture or pawn move since every position after it is in the same table
+    if (
+        state->probe_tablebases
+        && !excluded_move.has_value()
+        && depth >= state->limits->syzygy_probe_depth
+        && board->moves_since_last_pawn_move_or_capture == 0
+        && Syzygy::piece_count(board) <= Syzygy::max_pieces()
+    ) {
+        std::optional<Syzygy::WDL> wdl = Syzygy::probe_wdl(board);
+        if (wdl.has_value()) {
+            state->tablebase_hits += 1;
+            //cursed wins and blessed losses are draws under the fifty-move rule
+            float score = DRAW_SCORE;
+            TranspositionTable::Bound bound = TranspositionTable::Bound::Exact;
+            if (wdl.value() == Syzygy::Win) {
+                score = TABLEBASE_WIN_SCORE - ply;
+                bound = TranspositionTable::Bound::Lower;
+            } else if (wdl.value() == Syzygy::Loss) {
+                score = -TABLEBASE_WIN_SCORE + ply;
+                bound = TranspositionTable::Bound::Upper;
             }
+            if (
+                bound == TranspositionTable::Bound::Exact
+                || (bound == TranspositionTable::Bound::Lower && score >= beta)
+                || (bound == TranspositionTable::Bound::Upper && score <= alpha)
+            ) {
+                state->transposition_table->store(
+                    board->key,
+                    score_to_tt(score, ply),
+                    std::min(depth + TABLEBASE_DEPTH_BONUS, MAX_PLY),
+                    bound,
+                    std::nullopt
+                );
+                return score;
+            }
+        }
     }
-    if (depth == *our beginning depth*
-        set output move to bestMove
-    use move generator to move
-    */
+
+    float static_eval = Evaluation::evaluate_for_current_player(board, state->pawn_table, state->material_table);
+
+    //node level pruning, only done when the window is null so the exact score of the node doesn't matter
+    if (!is_pv_node && !in_check && !excluded_move.has_value()) {
+        if (depth <= REVERSE_FUTILITY_DEPTH && static_eval - REVERSE_FUTILITY_MARGIN * depth >= beta) {
+            SEARCH_STAT(state, reverse_futility_prunes);
+            return static_eval;
+        }
+
+        if (depth <= RAZORING_DEPTH && static_eval + RAZORING_MARGIN * depth < alpha) {
+            SEARCH_STAT(state, razoring_attempts);
+            float eval = quiescence(ply, alpha - NULL_WINDOW, alpha, board, state);
+            if (eval < alpha) {
+                SEARCH_STAT(state, razoring_prunes);
+                return eval;
+            }
+        }
+    }
+
+    //move level pruning never skips the first move so there is always a score to return
+    bool can_prune_moves = !in_check;
+    bool is_futile = depth <= FUTILITY_DEPTH
+        && static_eval + FUTILITY_BASE_MARGIN + FUTILITY_MARGIN * depth <= alpha;
+    bool can_extend = ply < state->root_depth * MAX_EXTENSION_FACTOR;
+
     std::vector<Move::Move> moves = MoveGenerator::generate_moves(board);
+    order_moves(board, &moves);
+    if (tt_move.has_value()) {
+        move_to_front(&moves, &tt_move.value());
+    }
     float bestEval = -std::numeric_limits<float>::infinity();
+    std::optional<Move::Move> best_move = std::nullopt;
+    int32_t moves_searched = 0;
+    int32_t quiets_searched = 0;
+    for (Move::Move move : moves) {
+        if (excluded_move.has_value() && move == excluded_move.value()) {
+            continue;
+        }
+        bool is_quiet = !is_capture(board, &move) && !move.promotion.has_value();
+
+        if (can_prune_moves && moves_searched > 0) {
+            if (
+                is_quiet
+                && depth <= LATE_MOVE_PRUNING_DEPTH
+                && quiets_searched >= LATE_MOVE_PRUNING_BASE + depth * depth
+            ) {
+                SEARCH_STAT(state, late_move_prunes);
+                continue;
+            }
+            if (
+                !is_quiet
+                && depth <= SEE_PRUNING_DEPTH
+                && Evaluation::static_exchange_evaluation(board, &move) < -SEE_PRUNING_MARGIN * depth
+            ) {
+                SEARCH_STAT(state, see_prunes);
+                continue;
+            }
+        }
+
+        int32_t extension = 0;
+        if (can_extend && depth >= SINGULAR_DEPTH && tt_entry.has_value() && tt_move.has_value() && move == tt_move.value()) {
+            TranspositionTable::Entry &entry = tt_entry.value();
+            if (entry.bound != TranspositionTable::Bound::Upper && entry.depth >= depth - SINGULAR_TT_DEPTH_MARGIN) {
+                SEARCH_STAT(state, singular_searches);
+                float singular_beta = entry.score - SINGULAR_MARGIN * depth;
+                state->excluded_moves[ply] = move;
+                float singular_eval = search((depth - 1) / 2, ply, singular_beta - NULL_WINDOW, singular_beta, board, state);
+                state->excluded_moves[ply] = std::nullopt;
+                if (state->stopped) {
+                    return 0.0;
+                }
+
+                if (singular_eval < singular_beta) {
+                    SEARCH_STAT(state, singular_extensions);
+                    extension = 1;
+                } else if (singular_beta >= beta) {
+                    SEARCH_STAT(state, multi_cuts);
+                    return singular_beta;
+                }
+            }
+        }
+
+        board->make_move(&move);
+        bool gives_check = board->is_in_check(board->current_player);
+
+        //quiet moves that give check are never futile
+        if (can_prune_moves && moves_searched > 0 && is_quiet && is_futile && !gives_check) {
+            SEARCH_STAT(state, futility_prunes);
+            board->unmake_move(&move);
+            continue;
+        }
+
+        if (can_extend && gives_check) {
+            SEARCH_STAT(state, check_extensions);
+            extension = 1;
+        }
+        int32_t new_depth = depth - 1 + extension;
+
+        float eval;
+        if (moves_searched == 0) {
+            eval = -search(new_depth, ply + 1, -beta, -alpha, board, state);
+        } else {
+            //assume the first move is best and only search the others fully if they prove to be better
+            eval = -search(new_depth, ply + 1, -alpha - NULL_WINDOW, -alpha, board, state);
+            if (eval > alpha && eval < beta) {
+                SEARCH_STAT(state, pvs_re_searches);
+                eval = -search(new_depth, ply + 1, -beta, -alpha, board, state);
+            }
+        }
+        board->unmake_move(&move);
+        if (state->stopped) {
+            return 0.0;
+        }
+
+        moves_searched += 1;
+        if (is_quiet) {
+            quiets_searched += 1;
+        }
+
+        if (eval > bestEval) {
+            bestEval = eval;
+        }
+        if (eval > alpha) {
+            alpha = eval;
+            best_move = move;
+            state->pv[ply].clear();
+            state->pv[ply].push_back(move);
+            state->pv[ply].insert(state->pv[ply].end(), state->pv[ply + 1].begin(), state->pv[ply + 1].end());
+        }
+        if (alpha >= beta) {
+            SEARCH_STAT(state, beta_cutoffs);
+            if (moves_searched == 1) {
+                SEARCH_STAT(state, first_move_cutoffs);
+            }
+            break;
+        }
+    }
+
+    if (moves.empty() || (excluded_move.has_value() && moves_searched == 0)) {
+        if (excluded_move.has_value()) {
+            //the excluded move is the only one, which makes it as singular as a move can be
+            return alpha;
+        }
+        return in_check ? -MATE_SCORE + ply : DRAW_SCORE;
+    }
+
+    if (!excluded_move.has_value() && moves_searched > 0) {
+        TranspositionTable::Bound bound = TranspositionTable::Bound::Upper;
+        if (bestEval >= beta) {
+            bound = TranspositionTable::Bound::Lower;
+        } else if (bestEval > original_alpha) {
+            bound = TranspositionTable::Bound::Exact;
+        }
+        state->transposition_table->store(board->key, score_to_tt(bestEval, ply), depth, bound, best_move);
+    }
+
+    return bestEval;
+}
+
+float Search::quiescence(int32_t ply, float alpha, float beta, Board::Board *board, SearchState *state) {
+    state->nodes += 1;
+    SEARCH_STAT(state, quiescence_nodes);
+    state->pv[ply].clear();
+    check_time(state);
+    if (state->stopped) {
+        return 0.0;
+    }
+    if (ply >= MAX_PLY) {
+        return Evaluation::evaluate_for_current_player(board, state->pawn_table, state->material_table);
+    }
+
+    //in check every move has to be looked at, since not capturing may not be an option
+    bool in_check = board->is_in_check(board->current_player);
+    float bestEval = -MATE_SCORE + ply;
+    std::vector<Move::Move> moves;
+    if (in_check) {
+        moves = MoveGenerator::generate_moves(board);
+    } else {
+        //the player to move can usually do at least as well as the static evaluation by not capturing
+        float stand_pat = Evaluation::evaluate_for_current_player(board, state->pawn_table, state->material_table);
+        if (stand_pat >= beta) {
+            return stand_pat;
+        }
+        if (stand_pat > alpha) {
+            alpha = stand_pat;
+        }
+        bestEval = stand_pat;
+        moves = MoveGenerator::generate_capture_moves(board);
+    }
+    order_moves(board, &moves);
+
     for (Move::Move move : moves) {
+        if (!in_check && Evaluation::static_exchange_evaluation(board, &move) < 0.0) {
+            continue;
+        }
+
         board->make_move(&move);
-        float eval = -search(depth - 1, board);
+        float eval = -quiescence(ply + 1, -beta, -alpha, board, state);
         board->unmake_move(&move);
-        if (eval > bestEval){
+        if (state->stopped) {
+            return 0.0;
+        }
+
+        if (eval > bestEval) {
             bestEval = eval;
         }
+        if (eval > alpha) {
+            alpha = eval;
+        }
+        if (alpha >= beta) {
+            break;
+        }
     }
 
     return bestEval;
 }
 
 
-void Search::init_search(int32_t depth, Board::Board* board) {
+float Search::search_root(int32_t depth, float alpha, float beta, Board::Board *board, SearchState *state) {
+    state->nodes += 1;
+    SEARCH_STAT(state, pv_nodes);
 
-    std::optional<Move::Move> best_move = std::nullopt;
-    /*
-    recursive searching
-    best_move
-    print it out
-    search
-    recursive searching
-    */
     std::vector<Move::Move> moves = MoveGenerator::generate_moves(board);
+    if (moves.empty()) {
+        return board->is_in_check(board->current_player) ? -MATE_SCORE : DRAW_SCORE;
+    }
+    order_moves(board, &moves);
+    if (!state->pv[0].empty()) {
+        move_to_front(&moves, &state->pv[0][0]);
+    }
+
     float bestEval = -std::numeric_limits<float>::infinity();
+    bool is_first_move = true;
     for (Move::Move move : moves) {
+        if (!is_root_move_searched(state, &move)) {
+            continue;
+        }
         board->make_move(&move);
-        float eval = -search(depth - 1, board);
+        float eval;
+        if (is_first_move) {
+            eval = -search(depth - 1, 1, -beta, -alpha, board, state);
+        } else {
+            eval = -search(depth - 1, 1, -alpha - NULL_WINDOW, -alpha, board, state);
+            if (eval > alpha && eval < beta) {
+                SEARCH_STAT(state, pvs_re_searches);
+                eval = -search(depth - 1, 1, -beta, -alpha, board, state);
+            }
+        }
         board->unmake_move(&move);
+        is_first_move = false;
+        if (state->stopped) {
+            break;
+        }
+
         if (eval > bestEval) {
             bestEval = eval;
-            best_move = move;
         }
+        if (eval > alpha) {
+            alpha = eval;
+            state->pv[0].clear();
+            state->pv[0].push_back(move);
+            state->pv[0].insert(state->pv[0].end(), state->pv[1].begin(), state->pv[1].end());
+        }
+        if (alpha >= beta) {
+            break;
+        }
+    }
+
+    return bestEval;
+}
+
+Search::SearchResult Search::init_search(
+    SearchLimits *limits,
+    Board::Board* board,
+    TimeManager::TimeManager *time_manager,
+    TranspositionTable::TranspositionTable *transposition_table,
+    PawnTable::PawnTable *pawn_table,
+    MaterialTable::MaterialTable *material_table
+) {
+
+    SearchState state = SearchState();
+    state.time_manager = time_manager;
+    state.transposition_table = transposition_table;
+    state.pawn_table = pawn_table;
+    state.material_table = material_table;
+    state.limits = limits;
+    state.probe_tablebases = Syzygy::max_pieces() > 0;
+
+    //with the root in the tablebases only the moves keeping its result by dtz are searched, and probing
+    //inside the tree would make them all look alike
+    if (state.probe_tablebases && Syzygy::piece_count(board) <= Syzygy::max_pieces()) {
+        std::optional<std::vector<Move::Move>> tablebase_moves = Syzygy::filter_root_moves(board);
+        if (tablebase_moves.has_value()) {
+            state.tablebase_root_moves = tablebase_moves.value();
+            bool any_searched = std::any_of(
+                state.tablebase_root_moves.begin(),
+                state.tablebase_root_moves.end(),
+                [&state](Move::Move &move) {
+                    return is_root_move_searched(&state, &move);
+                }
+            );
+            if (any_searched) {
+                state.probe_tablebases = false;
+            } else {
+                //searchmoves left none of them, so search what was asked for
+                state.tablebase_root_moves.clear();
+            }
+        }
+    }
+
+    std::vector<Move::Move> root_moves = MoveGenerator::generate_moves(board);
+    size_t searched_moves = std::count_if(root_moves.begin(), root_moves.end(), [&state](Move::Move &move) {
+        return is_root_move_searched(&state, &move);
+    });
+    size_t line_count = std::max<size_t>(1, std::min(limits->multi_pv, searched_moves));
+    std::vector<PvLine> lines = std::vector<PvLine>();
+    std::vector<Move::Move> best_pv = std::vector<Move::Move>();
+    float best_score = DRAW_SCORE;
+    std::vector<IterationResult> iterations = std::vector<IterationResult>();
+    for (int32_t current_depth = 1; current_depth <= std::min(limits->depth, MAX_PLY); current_depth++) {
+        if (current_depth > 1 && !time_manager->should_start_iteration()) {
+            Trace::instant("skip iteration", "time", {{"depth", (double) current_depth}});
+            break;
+        }
+        Trace::Scope iteration_scope = Trace::Scope("iteration", "search", {{"depth", (double) current_depth}});
+
+        state.root_depth = current_depth;
+        state.excluded_root_moves.clear();
+#ifdef DS_CHESS_STATS
+        uint64_t iteration_start_nodes = state.nodes;
+#endif
+        std::vector<PvLine> new_lines = std::vector<PvLine>();
+        //each line searches the root without the moves of the lines before it, all sharing the transposition table
+        for (size_t line = 0; line < line_count; line++) {
+            //the line's previous pv puts its move first and centers the aspiration window
+            state.pv[0] = line < lines.size() ? lines[line].pv : std::vector<Move::Move>();
+
+            float window = ASPIRATION_WINDOW;
+            float alpha = -std::numeric_limits<float>::infinity();
+            float beta = std::numeric_limits<float>::infinity();
+            if (current_depth >= ASPIRATION_DEPTH && line < lines.size() && std::isfinite(lines[line].score)) {
+                alpha = lines[line].score - window;
+                beta = lines[line].score + window;
+            }
+
+            float eval;
+            while (true) {
+                {
+                    Trace::Scope window_scope = Trace::Scope("root search", "search", {
+                        {"depth", (double) current_depth}, {"line", (double) line}, {"alpha", alpha}, {"beta", beta}
+                    });
+                    eval = search_root(current_depth, alpha, beta, board, &state);
+                }
+                if (state.stopped) {
+                    break;
+                }
+
+                if (eval <= alpha && std::isfinite(alpha)) {
+                    Trace::instant("fail low", "search", {{"score", eval}});
+                    //fail low: the best move so far is probably worse than expected
+                    beta = (alpha + beta) / 2.0f;
+                    alpha = eval - window;
+                    time_manager->on_fail_low();
+                } else if (eval >= beta && std::isfinite(beta)) {
+                    Trace::instant("fail high", "search", {{"score", eval}});
+                    beta = eval + window;
+                } else {
+                    break;
+                }
+                SEARCH_STAT(&state, aspiration_re_searches);
+
+                window *= ASPIRATION_GROWTH;
+                if (window > ASPIRATION_MAX_WINDOW) {
+                    alpha = -std::numeric_limits<float>::infinity();
+                    beta = std::numeric_limits<float>::infinity();
+                }
+            }
+
+            //an interrupted iteration may have only looked at some of the moves, though if it
+            //already found a new best move within the window that move is still trustworthy
+            if (line == 0 && !state.pv[0].empty()) {
+                best_pv = state.pv[0];
+            }
+            if (state.stopped) {
+                break;
+            }
+
+            new_lines.push_back(PvLine {eval, state.pv[0]});
+            if (state.pv[0].empty()) {
+                break;
+            }
+            state.excluded_root_moves.push_back(state.pv[0][0]);
+        }
+        if (state.stopped) {
+            break;
+        }
+
+#ifdef DS_CHESS_STATS
+        state.stats.iteration_nodes.push_back(state.nodes - iteration_start_nodes);
+#endif
+        std::stable_sort(new_lines.begin(), new_lines.end(), [](const PvLine &a, const PvLine &b) {
+            return a.score > b.score;
+        });
+        lines = new_lines;
+        best_score = lines[0].score;
+        if (!lines[0].pv.empty()) {
+            best_pv = lines[0].pv;
+            iterations.push_back(IterationResult {
+                current_depth, best_pv[0], best_score, state.nodes, time_manager->elapsed()
+            });
+        }
+        for (size_t line = 0; line < lines.size() && !limits->silent; line++) {
+            print_info(current_depth, line + 1, &lines[line], &state);
+        }
+
+        //go mate n: a mate in n moves takes at most 2n - 1 plies
+        if (limits->mate.has_value() && lines[0].score >= MATE_SCORE - (2 * limits->mate.value() - 1)) {
+            break;
+        }
+    }
+
+#ifdef DS_CHESS_STATS
+    if (!limits->silent) {
+        Stats::print(&state.stats);
+        Stats::publish(&state.stats);
+    }
+#endif
+
+    //an infinite search must not send its best move before the gui says stop
+    time_manager->wait_for_stop();
+    if (limits->silent) {
+        return SearchResult {best_pv, best_score, state.nodes, iterations};
+    }
+    if (best_pv.empty()) {
+        //checkmate or stalemate, there is nothing to play
+        std::cout << "bestmove 0000" << std::endl;
+        return SearchResult {best_pv, best_score, state.nodes, iterations};
     }
+    std::cout << "bestmove " << best_pv[0].to_string();
+    std::optional<Move::Move> ponder_move = get_ponder_move(board, &best_pv, transposition_table);
+    if (ponder_move.has_value()) {
+        std::cout << " ponder " << ponder_move.value().to_string();
+    }
+    std::cout << std::endl;
+    return SearchResult {best_pv, best_score, state.nodes, iterations};
+}
+
+std::optional<Move::Move> Search::get_ponder_move(
+    Board::Board *board,
+    std::vector<Move::Move> *pv,
+    TranspositionTable::TranspositionTable *transposition_table
+) {
+    if (pv->size() >= 2) {
+        return (*pv)[1];
+    }
+    //the pv was cut short by a transposition table hit, the table may still know the reply
+    Move::Move best_move = (*pv)[0];
+    board->make_move(&best_move);
+    std::optional<Move::Move> ponder_move = std::nullopt;
+    std::optional<TranspositionTable::Entry> entry = transposition_table->probe(board->key);
+    if (entry.has_value()) {
+        ponder_move = TranspositionTable::unpack_move(entry.value().move, board->current_player);
+    }
+    if (ponder_move.has_value() && !std::holds_alternative<Board::SuccessfulOperation>(
+        board->is_valid_move(&ponder_move.value())
+    )) {
+        ponder_move = std::nullopt;
+    }
+    board->unmake_move(&best_move);
+    return ponder_move;
+}
+
+void Search::print_info(int32_t depth, size_t multi_pv_index, PvLine *line, SearchState *state) {
+    int64_t time = state->time_manager->elapsed();
+    float score = line->score;
+    std::cout << "info depth " << depth << " multipv " << multi_pv_index;
+    if (is_mate_score(score)) {
+        //uci counts mates in moves rather than plies, negative when getting mated
+        int32_t plies = (int32_t) (MATE_SCORE - std::abs(score));
+        std::cout << " score mate " << (score > 0 ? (plies + 1) / 2 : -plies / 2);
+    } else {
+        std::cout << " score cp " << (int32_t) std::round(score * 100.0f);
+    }
+    std::cout << " nodes " << state->nodes
+        << " time " << time
+        << " nps " << state->nodes * 1000 / std::max<int64_t>(time, 1);
+    if (Syzygy::max_pieces() > 0) {
+        std::cout << " tbhits " << state->tablebase_hits;
+    }
+    std::cout << " pv";
+    for (Move::Move &move : line->pv) {
+        std::cout << " " << move.to_string();
+    }
+    std::cout << std::endl;
+}
+
+void Search::move_to_front(std::vector<Move::Move> *moves, Move::Move *move) {
+    auto it = std::find(moves->begin(), moves->end(), *move);
+    if (it != moves->end()) {
+        std::rotate(moves->begin(), it, it + 1);
+    }
+}
+
+bool Search::is_mate_score(float score) {
+    return std::abs(score) >= MATE_BOUND;
+}
 
-    std::cout << "bestmove " << best_move.value().to_string() << std::endl;
-}
\ No newline at end of file
+float Search::score_to_tt(float score, int32_t ply) {
+    if (score >= TABLEBASE_BOUND) {
+        return score + ply;
+    } else if (score <= -TABLEBASE_BOUND) {
+        return score - ply;
+    }
+    return score;
+}
+
+float Search::score_from_tt(float score, int32_t ply) {
+    if (score >= TABLEBASE_BOUND) {
+        return score - ply;
+    } else if (score <= -TABLEBASE_BOUND) {
+        return score + ply;
+    }
+    return score;
+}
+
+bool Search::is_tt_cutoff(TranspositionTable::Entry *entry, int32_t depth, float alpha, float beta) {
+    if (entry->depth < depth) {
+        return false;
+    }
+    switch (entry->bound) {
+        case TranspositionTable::Bound::Exact:
+            return true;
+        case TranspositionTable::Bound::Lower:
+            return entry->score >= beta;
+        case TranspositionTable::Bound::Upper:
+            return entry->score <= alpha;
+    }
+    return false;
+}
+
+void Search::check_time(SearchState *state) {
+    //checked on every node so that node limited searches are reproducible
+    if (state->limits->nodes.has_value() && state->nodes >= state->limits->nodes.value()) {
+        state->stopped = true;
+    }
+    if (state->nodes % TIME_CHECK_INTERVAL == 0 && state->time_manager->should_stop()) {
+        Trace::instant("hard stop", "time", {{"nodes", (double) state->nodes}});
+        state->stopped = true;
+    }
+}
+
+bool Search::is_root_move_searched(SearchState *state, Move::Move *move) {
+    std::vector<Move::Move> &search_moves = state->limits->search_moves;
+    if (!search_moves.empty() && std::find(search_moves.begin(), search_moves.end(), *move) == search_moves.end()) {
+        return false;
+    }
+    std::vector<Move::Move> &tablebase_moves = state->tablebase_root_moves;
+    if (
+        !tablebase_moves.empty()
+        && std::find(tablebase_moves.begin(), tablebase_moves.end(), *move) == tablebase_moves.end()
+    ) {
+        return false;
+    }
+    //moves already reported by earlier multi pv lines
+    std::vector<Move::Move> &excluded = state->excluded_root_moves;
+    return std::find(excluded.begin(), excluded.end(), *move) == excluded.end();
+}
+
+bool Search::is_capture(Board::Board *board, Move::Move *move) {
+    if (board->is_piece_capturable(move->to, board->current_player)) {
+        return true;
+    }
+    //en passant lands on an empty square
+    return board->en_passant.has_value() && move->to == board->en_passant.value()
+        && board->board[move->from].has_value()
+        && board->board[move->from].value().piece_type == Move::PieceType::Pawn;
+}
+
+void Search::order_moves(Board::Board *board, std::vector<Move::Move> *moves) {
+    std::vector<std::pair<float, Move::Move>> scored_moves = std::vector<std::pair<float, Move::Move>>();
+    scored_moves.reserve(moves->size());
+    for (Move::Move move : *moves) {
+        float score = 0.0;
+        if (is_capture(board, &move)) {
+            Move::PieceType victim_type = board->board[move.to].has_value()
+                ? board->board[move.to].value().piece_type
+                : Move::PieceType::Pawn;
+            float victim = Evaluation::get_piece_type_value(victim_type);
+            float attacker = Evaluation::get_piece_type_value(board->board[move.from].value().piece_type);
+            score += 100.0f + victim * 10.0f - attacker;
+        }
+        if (move.promotion.has_value()) {
+            score += 50.0f + Evaluation::get_piece_type_value(move.promotion.value().piece_type);
+        }
+        scored_moves.push_back({score, move});
+    }
+    std::stable_sort(scored_moves.begin(), scored_moves.end(), [](const auto &a, const auto &b) {
+        return a.first > b.first;
+    });
+    for (size_t i = 0; i < scored_moves.size(); i++) {
+        (*moves)[i] = scored_moves[i].second;
+    }
+}
@@ -5,14 +5,182 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 #include "board.h"
+#include "material_table.h"
+#include "pawn_table.h"
+#include "stats.h"
+#include "time_manager.h"
+#include "transposition_table.h"
 
 namespace Search {
+    const int32_t MAX_PLY = 128;
+    const float DRAW_SCORE = 0.0;
+    //score of being checkmated right now, mate in n plies scores MATE_SCORE - n
+    const float MATE_SCORE = 10000.0;
+    //any score beyond this is a forced mate
+    const float MATE_BOUND = MATE_SCORE - MAX_PLY;
+    //a win proven by the tablebases, which like a mate is scored by its distance from the root
+    //and ranks below every mate, since the line to the actual mate is still unknown
+    const float TABLEBASE_WIN_SCORE = MATE_BOUND - 1;
+    //any score beyond this is a tablebase win or a forced mate
+    const float TABLEBASE_BOUND = TABLEBASE_WIN_SCORE - MAX_PLY;
+    //depth credited to a tablebase result stored in the transposition table, no search overrides it
+    const int32_t TABLEBASE_DEPTH_BONUS = 6;
+    //how often (in nodes) the search asks the time manager whether it has to stop
+    const uint64_t TIME_CHECK_INTERVAL = 2048;
+
+    //aspiration windows: from this depth on an iteration is first searched with a window
+    //around the previous iteration's score, widened every time the score falls outside of it
+    const int32_t ASPIRATION_DEPTH = 4;
+    const float ASPIRATION_WINDOW = 0.25;
+    const float ASPIRATION_GROWTH = 2.0;
+    //past this width the window is opened up completely
+    const float ASPIRATION_MAX_WINDOW = 5.0;
+
+    //width of the window used to test whether a move can beat the current best one
+    const float NULL_WINDOW = 0.01;
+
+    //reverse futility pruning (static null move): the static evaluation is so far above beta
+    //that the opponent is not expected to recover within the remaining depth
+    const int32_t REVERSE_FUTILITY_DEPTH = 6;
+    const float REVERSE_FUTILITY_MARGIN = 0.8;
+    //razoring: the static evaluation is so far below alpha that only captures can save the node
+    const int32_t RAZORING_DEPTH = 3;
+    const float RAZORING_MARGIN = 2.0;
+    //futility pruning: quiet moves cannot raise the static evaluation above alpha
+    const int32_t FUTILITY_DEPTH = 6;
+    const float FUTILITY_BASE_MARGIN = 0.8;
+    const float FUTILITY_MARGIN = 1.0;
+    //late move count pruning: past this many quiet moves the rest are unlikely to matter
+    const int32_t LATE_MOVE_PRUNING_DEPTH = 6;
+    const int32_t LATE_MOVE_PRUNING_BASE = 3;
+    //static exchange pruning: captures losing more than this per ply of depth are skipped
+    const int32_t SEE_PRUNING_DEPTH = 6;
+    const float SEE_PRUNING_MARGIN = 1.0;
+
+    //singular extensions: the transposition table move is extended when a reduced search
+    //without it fails low against a margin below its score, if the reduced search instead beats
+    //beta several moves refute the node and it is cut straight away (multi-cut)
+    const int32_t SINGULAR_DEPTH = 6;
+    const int32_t SINGULAR_TT_DEPTH_MARGIN = 3;
+    const float SINGULAR_MARGIN = 0.02;
+    //extensions stop once a line is this many times longer than the iteration's depth
+    const int32_t MAX_EXTENSION_FACTOR = 2;
+
+    //what the gui asked the search for, besides the clock which the time manager looks after
+    struct SearchLimits {
+        int32_t depth = MAX_PLY;
+        //stop after this many nodes, which unlike time gives the same result on every run
+        std::optional<uint64_t> nodes = std::nullopt;
+        //stop once a mate in this many moves is found
+        std::optional<int32_t> mate = std::nullopt;
+        //only these root moves are searched, or every move if empty
+        std::vector<Move::Move> search_moves = std::vector<Move::Move>();
+        //number of best lines reported
+        size_t multi_pv = 1;
+        //nothing is printed, for searches run by the engine itself rather than a gui
+        bool silent = false;
+        //tablebases are probed in nodes with at least this much depth left
+        int32_t syzygy_probe_depth = 1;
+    };
+
+    //one of the lines reported in multi pv mode
+    struct PvLine {
+        float score;
+        std::vector<Move::Move> pv;
+    };
+
+    //the outcome of one completed iteration
+    struct IterationResult {
+        int32_t depth;
+        Move::Move best_move;
+        float score;
+        uint64_t nodes;
+        //milliseconds since the search started
+        int64_t time;
+    };
+
+    //what a finished search found
+    struct SearchResult {
+        //empty on checkmate or stalemate
+        std::vector<Move::Move> pv;
+        float score;
+        uint64_t nodes;
+        std::vector<IterationResult> iterations;
+    };
+
+    struct SearchState {
+        uint64_t nodes = 0;
+        TimeManager::TimeManager *time_manager = nullptr;
+        TranspositionTable::TranspositionTable *transposition_table = nullptr;
+        //owned by whoever runs the search, once per thread, so they're allocated once and kept across searches
+        PawnTable::PawnTable *pawn_table = nullptr;
+        MaterialTable::MaterialTable *material_table = nullptr;
+        SearchLimits *limits = nullptr;
+        int32_t root_depth = 0;
+        //set once the time manager or the node limit says so, every score computed afterwards is meaningless
+        bool stopped = false;
+        //principal variation found from each ply, pv[0] is the line from the root
+        std::vector<std::vector<Move::Move>> pv = std::vector<std::vector<Move::Move>>(MAX_PLY + 1);
+        //move skipped by the singular extension search at each ply
+        std::vector<std::optional<Move::Move>> excluded_moves = std::vector<std::optional<Move::Move>>(MAX_PLY + 1);
+        //root moves already taken by earlier lines of a multi pv search
+        std::vector<Move::Move> excluded_root_moves = std::vector<Move::Move>();
+        //probe the tablebases inside the tree, turned off once they already decided the root moves
+        bool probe_tablebases = false;
+        uint64_t tablebase_hits = 0;
+        //the root moves keeping the tablebase result, every move if empty
+        std::vector<Move::Move> tablebase_root_moves = std::vector<Move::Move>();
+#ifdef DS_CHESS_STATS
+        Stats::SearchStats stats = Stats::SearchStats();
+#endif
+    };
+
+    float search(int32_t depth, int32_t ply, float alpha, float beta, Board::Board *board, SearchState *state);
+    float quiescence(int32_t ply, float alpha, float beta, Board::Board *board, SearchState *state);
+    //searches every root move, leaving the best line in state->pv[0]
+    float search_root(int32_t depth, float alpha, float beta, Board::Board *board, SearchState *state);
 
-    float search(int32_t depth, Board::Board *board);
+    //iterative deepening until the limits are reached or the time manager stops it, reporting the best moves
+    SearchResult init_search(
+        SearchLimits *limits,
+        Board::Board *board,
+        TimeManager::TimeManager *time_manager,
+        TranspositionTable::TranspositionTable *transposition_table,
+        PawnTable::PawnTable *pawn_table,
+        MaterialTable::MaterialTable *material_table
+    );
+    void print_info(int32_t depth, size_t multi_pv_index, PvLine *line, SearchState *state);
+    //the reply expected after the best move, sent along with it for the gui to ponder on
+    std::optional<Move::Move> get_ponder_move(
+        Board::Board *board,
+        std::vector<Move::Move> *pv,
+        TranspositionTable::TranspositionTable *transposition_table
+    );
 
-    void init_search(int32_t depth, Board::Board *board);
+    //including en passant
+    bool is_capture(Board::Board *board, Move::Move *move);
+    //sorts captures (most valuable victim, least valuable attacker) ahead of quiet moves
+    void order_moves(Board::Board *board, std::vector<Move::Move> *moves);
+    //moves the previous best move to the front of the list
+    void move_to_front(std::vector<Move::Move> *moves, Move::Move *move);
+    //true if the score from a transposition table entry can be returned without searching
+    bool is_tt_cutoff(TranspositionTable::Entry *entry, int32_t depth, float alpha, float beta);
+    bool is_mate_score(float score);
+    //mate and tablebase scores are stored in the transposition table relative to the position rather
+    //than the root, since the same position can be reached at different plies
+    float score_to_tt(float score, int32_t ply);
+    float score_from_tt(float score, int32_t ply);
+    //stops the search once the time manager's hard limit or the node limit is hit
+    void check_time(SearchState *state);
+    //false for root moves left out by searchmoves, losing the tablebase result or already taken by an
+    //earlier multi pv line
+    bool is_root_move_searched(SearchState *state, Move::Move *move);
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,55 @@
+#include "stats.h"
+
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+//written by the search thread, read by the uci thread
+static std::mutex last_search_mutex;
+static std::optional<Stats::SearchStats> last_search_stats = std::nullopt;
+
+static double percent(uint64_t part, uint64_t total) {
+    return total == 0 ? 0.0 : 100.0 * part / total;
+}
+
+void Stats::print(SearchStats *stats) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "info string nodes pv " << stats->pv_nodes
+        << " non-pv " << stats->non_pv_nodes
+        << " quiescence " << stats->quiescence_nodes << "\n";
+    std::cout << "info string tt probes " << stats->tt_probes
+        << " hits " << stats->tt_hits << " (" << percent(stats->tt_hits, stats->tt_probes) << "%)"
+        << " cutoffs " << stats->tt_cutoffs << " (" << percent(stats->tt_cutoffs, stats->tt_probes) << "%)\n";
+    std::cout << "info string beta cutoffs " << stats->beta_cutoffs
+        << " first move " << stats->first_move_cutoffs
+        << " (" << percent(stats->first_move_cutoffs, stats->beta_cutoffs) << "%)\n";
+    std::cout << "info string re-searches pvs " << stats->pvs_re_searches
+        << " aspiration " << stats->aspiration_re_searches << "\n";
+    std::cout << "info string pruned reverse-futility " << stats->reverse_futility_prunes
+        << " razoring " << stats->razoring_prunes << "/" << stats->razoring_attempts
+        << " futility " << stats->futility_prunes
+        << " late-move " << stats->late_move_prunes
+        << " see " << stats->see_prunes << "\n";
+    std::cout << "info string extensions check " << stats->check_extensions
+        << " singular " << stats->singular_extensions << "/" << stats->singular_searches
+        << " multi-cut " << stats->multi_cuts << "\n";
+    //effective branching factor: how many times more nodes each iteration took than the one before
+    std::cout << "info string branching factor";
+    for (size_t i = 1; i < stats->iteration_nodes.size(); i++) {
+        double factor = stats->iteration_nodes[i - 1] == 0
+            ? 0.0
+            : (double) stats->iteration_nodes[i] / stats->iteration_nodes[i - 1];
+        std::cout << " " << (i + 1) << ":" << std::setprecision(2) << factor;
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
+
+void Stats::publish(SearchStats *stats) {
+    std::lock_guard<std::mutex> lock(last_search_mutex);
+    last_search_stats = *stats;
+}
+
+std::optional<Stats::SearchStats> Stats::last_search() {
+    std::lock_guard<std::mutex> lock(last_search_mutex);
+    return last_search_stats;
+}
@@ -0,0 +1,59 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//the counters are only kept when built with DS_CHESS_STATS (cmake -DDS_CHESS_STATS=ON),
+//otherwise SEARCH_STAT compiles to nothing and costs the search nothing
+#ifdef DS_CHESS_STATS
+#define SEARCH_STAT(state, counter) ((state)->stats.counter += 1)
+#else
+#define SEARCH_STAT(state, counter) ((void) 0)
+#endif
+
+namespace Stats {
+    struct SearchStats {
+        //nodes by type, the root counts as a pv node
+        uint64_t pv_nodes = 0;
+        uint64_t non_pv_nodes = 0;
+        uint64_t quiescence_nodes = 0;
+
+        uint64_t tt_probes = 0;
+        uint64_t tt_hits = 0;
+        uint64_t tt_cutoffs = 0;
+
+        //how good move ordering is: the share of beta cutoffs caused by the first move searched
+        uint64_t beta_cutoffs = 0;
+        uint64_t first_move_cutoffs = 0;
+
+        //null window searches that had to be repeated with the full window
+        uint64_t pvs_re_searches = 0;
+        //root searches repeated after failing outside of the aspiration window
+        uint64_t aspiration_re_searches = 0;
+
+        uint64_t reverse_futility_prunes = 0;
+        uint64_t razoring_attempts = 0;
+        uint64_t razoring_prunes = 0;
+        uint64_t futility_prunes = 0;
+        uint64_t late_move_prunes = 0;
+        uint64_t see_prunes = 0;
+
+        uint64_t check_extensions = 0;
+        uint64_t singular_searches = 0;
+        uint64_t singular_extensions = 0;
+        uint64_t multi_cuts = 0;
+
+        //nodes spent on each completed iteration, iteration_nodes[0] is depth 1
+        std::vector<uint64_t> iteration_nodes = std::vector<uint64_t>();
+    };
+
+    //prints the counters as info string lines
+    void print(SearchStats *stats);
+    //keeps the counters of a finished search for the stats command
+    void publish(SearchStats *stats);
+    std::optional<SearchStats> last_search();
+};
+
+#endif
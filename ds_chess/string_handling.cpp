@@ -4,23 +4,61 @@
 
 #include "string_handling.h"
 
-#include <iostream>
-#include <string>
-#include <utility>
-#include <vector>
-
-std::vector<std::string> StringHandling::split(std::string input, char delimiter) {
-    std::vector <std::string> output = std::vector<std::string>();
-
-    std::string string = std::move(input);
-    size_t index = string.find(delimiter);
-    while (index != -1) {
-        output.push_back(string.substr(0, index));
-        string = string.substr(index + 1);
-        index = string.find(delimiter);
+#include <charconv>
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static std::string_view skip_whitespace(std::string_view input) {
+    size_t index = 0;
+    while (index < input.size() && is_whitespace(input[index])) {
+        index++;
     }
-    if (!string.empty()) {
-        output.push_back(string);
+    return input.substr(index);
+}
+
+StringHandling::Tokenizer::Tokenizer(std::string_view input) :
+    remaining(skip_whitespace(input))
+{}
+
+bool StringHandling::Tokenizer::has_next() const {
+    return !this->remaining.empty();
+}
+
+std::string_view StringHandling::Tokenizer::next() {
+    std::string_view token = this->peek();
+    this->remaining = skip_whitespace(this->remaining.substr(token.size()));
+    return token;
+}
+
+std::string_view StringHandling::Tokenizer::peek() const {
+    size_t length = 0;
+    while (length < this->remaining.size() && !is_whitespace(this->remaining[length])) {
+        length++;
+    }
+    return this->remaining.substr(0, length);
+}
+
+std::string_view StringHandling::Tokenizer::rest() {
+    std::string_view rest = this->remaining;
+    while (!rest.empty() && is_whitespace(rest.back())) {
+        rest.remove_suffix(1);
+    }
+    this->remaining = std::string_view();
+    return rest;
+}
+
+std::string_view StringHandling::span(std::string_view first, std::string_view last) {
+    return std::string_view(first.data(), last.data() + last.size() - first.data());
+}
+
+int64_t StringHandling::to_int(std::string_view token) {
+    int64_t value = 0;
+    const char *begin = token.data();
+    if (!token.empty() && token[0] == '+') {
+        begin += 1;
     }
-    return output;
-}
\ No newline at end of file
+    std::from_chars(begin, token.data() + token.size(), value);
+    return value;
+}
@@ -5,11 +5,31 @@
 #ifndef STRING_HANDLING_H
 #define STRING_HANDLING_H
 
-#include <string>
-#include <vector>
+#include <cstdint>
+#include <string_view>
 
 namespace StringHandling {
-    std::vector<std::string> split(std::string input, char delimiter);
+    //walks over the whitespace separated tokens of a line without copying or allocating,
+    //every token is a view into the line, which has to outlive the tokenizer and its tokens
+    class Tokenizer {
+    public:
+        Tokenizer(std::string_view input);
+        bool has_next() const;
+        //the next token, empty once every token has been read
+        std::string_view next();
+        //the next token without consuming it
+        std::string_view peek() const;
+        //everything left on the line (such as a uci option value, which may contain spaces), consuming it
+        std::string_view rest();
+    private:
+        //always starts at a token or is empty
+        std::string_view remaining;
+    };
+
+    //joins two tokens from the same line into one view running from the start of first to the end of last
+    std::string_view span(std::string_view first, std::string_view last);
+    //the leading integer of token, 0 if there is none, like atoi
+    int64_t to_int(std::string_view token);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,1278 @@
+#include "syzygy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+#include "mapped_file.h"
+#include "move_generator.h"
+
+//the table format and its indexing follow the reference prober (Ronald de Man's tbprobe, as used by Stockfish)
+namespace Syzygy {
+    const uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+    const uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+    //bigger blocks, spans or codes than these only come from a damaged file. A code is read from 64 bits
+    //topped up 32 at a time, so it can't be any longer than 32
+    const uint8_t MAX_BLOCK_SIZE_BITS = 31;
+    const uint8_t MAX_SPAN_BITS = 31;
+    const uint8_t MAX_SYMBOL_LENGTH = 32;
+    //symbols that expand to a value rather than a pair have this right symbol
+    const uint16_t LEAF_SYMBOL = 0xFFF;
+    //the values a wdl table stores, loss to win
+    const int32_t WDL_VALUES = 5;
+
+    enum TableType {
+        WdlTable,
+        DtzTable
+    };
+
+    //flags of each compressed table
+    enum TableFlag : uint8_t {
+        //which side to move a dtz table stores
+        SideToMoveFlag = 1,
+        //dtz values are remapped through the map following the table sizes
+        MappedFlag = 2,
+        //dtz values of wins (or losses) are stored in plies rather than moves
+        WinPliesFlag = 4,
+        LossPliesFlag = 8,
+        //the dtz map holds 16 bit values
+        WideFlag = 16,
+        //every position of the table has the same value
+        SingleValueFlag = 128
+    };
+
+    //how far set_symbol_length got with a symbol, a pair can't contain itself
+    enum SymbolState : uint8_t {
+        Unvisited,
+        Visiting,
+        Visited
+    };
+
+    enum ProbeState {
+        Fail,
+        Ok,
+        //a dtz table only stores one side to move and it's the other one
+        ChangeSideToMove,
+        //the best move is a capture or pawn move, the stored dtz may be anything
+        ZeroingBestMove
+    };
+
+    //the indexing and decompression information of one table of a file. A file has one for each side
+    //to move (unless both sides have the same pieces, or it's a dtz file) and, with pawns, for each
+    //file a-d of the leading pawn
+    struct PairsData {
+        uint8_t flags;
+        uint8_t max_symbol_length;
+        uint8_t min_symbol_length;
+        uint32_t block_count;
+        size_t block_size;
+        //there is a sparse index entry about every span values
+        size_t span;
+        //little endian, the lowest symbol of each length
+        const uint8_t *lowest_symbol;
+        //3 bytes per symbol: the 12 bit left and right symbols it expands to
+        const uint8_t *tree;
+        uint16_t symbol_count;
+        //little endian 16 bit, the number of values minus one stored in each block
+        const uint8_t *block_length;
+        uint32_t block_length_size;
+        //6 bytes per entry: little endian 32 bit block and 16 bit offset within it
+        const uint8_t *sparse_index;
+        size_t sparse_index_size;
+        const uint8_t *data;
+        //the end of the file, which the codes of the last block can't be read past
+        const uint8_t *data_end;
+        //the lowest symbol of each length, left aligned in 64 bits
+        std::vector<uint64_t> base64;
+        //the number of values minus one each symbol expands to
+        std::vector<uint8_t> symbol_length;
+        //the pieces in the order they're encoded, which also defines the groups
+        uint8_t pieces[MAX_PIECES];
+        uint64_t group_index[MAX_PIECES + 1];
+        int32_t group_length[MAX_PIECES + 1];
+        //where the values of win, loss, cursed win and blessed loss start in a dtz map, and how many there are
+        uint16_t map_index[4];
+        uint16_t map_length[4];
+    };
+
+    struct Table {
+        TableType type;
+        //like KRPvKN, the stronger side first
+        std::string name;
+        //material keys with the stronger side white and with it black
+        uint64_t key;
+        uint64_t key2;
+        size_t piece_count;
+        bool has_pawns;
+        bool has_unique_pieces;
+        //pawns of the leading color, which has the fewer pawns, and of the other one
+        uint8_t pawn_count[2];
+
+        //the file is mapped on the first probe, ready is set once that was tried
+        std::atomic<bool> ready;
+        bool available;
+        MappedFile::MappedFile file;
+        const uint8_t *map;
+        PairsData items[2][4];
+
+        Table(TableType type, const std::string &name);
+        PairsData *get(int32_t side, int32_t file) {
+            return &this->items[this->type == WdlTable ? side % 2 : 0][this->has_pawns ? file : 0];
+        }
+    };
+
+    struct TablePair {
+        Table wdl;
+        Table dtz;
+
+        TablePair(const std::string &name) : wdl(WdlTable, name), dtz(DtzTable, name) {}
+    };
+
+    //indexing tables, filled by init_indices
+    int32_t MAP_B1H1H7[64];
+    int32_t MAP_A1D1D4[64];
+    int32_t MAP_KK[10][64];
+    uint64_t BINOMIAL[6][64];
+    int32_t MAP_PAWNS[64];
+    uint64_t LEAD_PAWN_INDEX[6][64];
+    uint64_t LEAD_PAWNS_SIZE[6][4];
+
+    std::deque<TablePair> tables;
+    std::unordered_map<uint64_t, TablePair *> tables_by_key;
+    std::vector<std::string> directories;
+    size_t largest = 0;
+    std::mutex map_mutex;
+};
+
+static uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint32_t read_be32(const uint8_t *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static uint64_t read_be64(const uint8_t *p) {
+    return ((uint64_t) read_be32(p) << 32) | read_be32(p + 4);
+}
+
+//whether size more bytes starting at data are still in the file
+static bool fits(const uint8_t *data, const uint8_t *end, size_t size) {
+    return data <= end && (size_t) (end - data) >= size;
+}
+
+static uint16_t left_symbol(Syzygy::PairsData *d, uint16_t symbol) {
+    const uint8_t *lr = d->tree + 3 * symbol;
+    return (uint16_t) (((lr[1] & 0xF) << 8) | lr[0]);
+}
+
+static uint16_t right_symbol(Syzygy::PairsData *d, uint16_t symbol) {
+    const uint8_t *lr = d->tree + 3 * symbol;
+    return (uint16_t) ((lr[2] << 4) | (lr[1] >> 4));
+}
+
+static int32_t rank_of(int32_t square) {
+    return square >> 3;
+}
+
+static int32_t file_of(int32_t square) {
+    return square & 7;
+}
+
+//positive above the a1-h8 diagonal, negative below it
+static int32_t off_diagonal(int32_t square) {
+    return rank_of(square) - file_of(square);
+}
+
+static int32_t sign_of(int32_t value) {
+    return (0 < value) - (value < 0);
+}
+
+//the syzygy piece code: 1-6 for white pawn to king, 9-14 for black
+static uint8_t piece_code(Move::Piece piece) {
+    return (uint8_t) ((piece.color == Move::Color::Black ? 8 : 0) | (piece.piece_type + 1));
+}
+
+static std::optional<Move::PieceType> piece_type_from_char(char c) {
+    switch (c) {
+    case 'P': return Move::PieceType::Pawn;
+    case 'N': return Move::PieceType::Knight;
+    case 'B': return Move::PieceType::Bishop;
+    case 'R': return Move::PieceType::Rook;
+    case 'Q': return Move::PieceType::Queen;
+    case 'K': return Move::PieceType::King;
+    default: return std::nullopt;
+    }
+}
+
+Syzygy::Table::Table(TableType type, const std::string &name)
+    : type(type), name(name), key(0), key2(0), piece_count(0), has_pawns(false), has_unique_pieces(false),
+    pawn_count{0, 0}, ready(false), available(false), file(), map(nullptr), items() {
+    size_t counts[2][6] = {};
+    size_t side = 0;
+    for (char c : name) {
+        if (c == 'v') {
+            side = 1;
+            continue;
+        }
+        Move::PieceType piece_type = piece_type_from_char(c).value();
+        counts[side][piece_type] += 1;
+        this->key += 1ULL << (4 * (side * 6 + piece_type));
+        this->key2 += 1ULL << (4 * ((1 - side) * 6 + piece_type));
+        this->piece_count += 1;
+    }
+
+    this->has_pawns = counts[0][Move::PieceType::Pawn] + counts[1][Move::PieceType::Pawn] > 0;
+    for (size_t color = 0; color < 2; color++) {
+        for (size_t piece_type = Move::PieceType::Pawn; piece_type < Move::PieceType::King; piece_type++) {
+            if (counts[color][piece_type] == 1) {
+                this->has_unique_pieces = true;
+            }
+        }
+    }
+
+    //the leading color is the one with fewer pawns (but some), which compresses better
+    size_t white_pawns = counts[0][Move::PieceType::Pawn];
+    size_t black_pawns = counts[1][Move::PieceType::Pawn];
+    bool white_leads = black_pawns == 0 || (white_pawns > 0 && black_pawns >= white_pawns);
+    this->pawn_count[0] = (uint8_t) (white_leads ? white_pawns : black_pawns);
+    this->pawn_count[1] = (uint8_t) (white_leads ? black_pawns : white_pawns);
+}
+
+static void init_indices() {
+    using namespace Syzygy;
+
+    int32_t code = 0;
+    for (int32_t s = 0; s < 64; s++) {
+        if (off_diagonal(s) < 0) {
+            MAP_B1H1H7[s] = code++;
+        }
+    }
+
+    //the a1-d1-d4 triangle, the squares on the diagonal last
+    std::vector<int32_t> diagonal = std::vector<int32_t>();
+    code = 0;
+    for (int32_t s = 0; s <= 27; s++) {
+        if (off_diagonal(s) < 0 && file_of(s) <= 3) {
+            MAP_A1D1D4[s] = code++;
+        } else if (off_diagonal(s) == 0 && file_of(s) <= 3) {
+            diagonal.push_back(s);
+        }
+    }
+    for (int32_t s : diagonal) {
+        MAP_A1D1D4[s] = code++;
+    }
+
+    //the 462 legal ways to place two kings with the first in the a1-d1-d4 triangle, if the first is on
+    //the diagonal the second isn't above it. Both on the diagonal come last
+    std::vector<std::pair<int32_t, int32_t>> both_on_diagonal = std::vector<std::pair<int32_t, int32_t>>();
+    code = 0;
+    for (int32_t index = 0; index < 10; index++) {
+        for (int32_t s1 = 0; s1 <= 27; s1++) {
+            //b1 is the square mapped to 0, every other square outside the triangle is 0 as well
+            if (MAP_A1D1D4[s1] != index || (index == 0 && s1 != 1)) {
+                continue;
+            }
+            for (int32_t s2 = 0; s2 < 64; s2++) {
+                if (std::abs(rank_of(s1) - rank_of(s2)) <= 1 && std::abs(file_of(s1) - file_of(s2)) <= 1) {
+                    continue;
+                } else if (off_diagonal(s1) == 0 && off_diagonal(s2) > 0) {
+                    continue;
+                } else if (off_diagonal(s1) == 0 && off_diagonal(s2) == 0) {
+                    both_on_diagonal.push_back({index, s2});
+                } else {
+                    MAP_KK[index][s2] = code++;
+                }
+            }
+        }
+    }
+    for (auto [index, s2] : both_on_diagonal) {
+        MAP_KK[index][s2] = code++;
+    }
+
+    //BINOMIAL[k][n]: the ways to choose k of n squares
+    BINOMIAL[0][0] = 1;
+    for (int32_t n = 1; n < 64; n++) {
+        for (int32_t k = 0; k < 6 && k <= n; k++) {
+            BINOMIAL[k][n] = (k > 0 ? BINOMIAL[k - 1][n - 1] : 0) + (k < n ? BINOMIAL[k][n - 1] : 0);
+        }
+    }
+
+    //MAP_PAWNS numbers a2-h7 so the leading pawn, the one nearest the edge and then the lowest rank, has
+    //the highest value, which is also the number of squares left for the other pawns
+    int32_t available_squares = 47;
+    for (int32_t lead_pawns = 1; lead_pawns <= 5; lead_pawns++) {
+        for (int32_t file = 0; file < 4; file++) {
+            uint64_t index = 0;
+            for (int32_t rank = 1; rank <= 6; rank++) {
+                int32_t s = rank * 8 + file;
+                if (lead_pawns == 1) {
+                    MAP_PAWNS[s] = available_squares--;
+                    MAP_PAWNS[s ^ 7] = available_squares--;
+                }
+                LEAD_PAWN_INDEX[lead_pawns][s] = index;
+                index += BINOMIAL[lead_pawns - 1][MAP_PAWNS[s]];
+            }
+            LEAD_PAWNS_SIZE[lead_pawns][file] = index;
+        }
+    }
+}
+
+//groups the pieces encoded together: pieces of the same kind, apart from the leading group which is
+//three unique pieces (or the two kings) without pawns, and the leading pawns with them
+static bool set_groups(Syzygy::Table *table, Syzygy::PairsData *d, int32_t order[2], int32_t file) {
+    using namespace Syzygy;
+
+    int32_t n = 0;
+    int32_t first_length = table->has_pawns ? 0 : table->has_unique_pieces ? 3 : 2;
+    d->group_length[n] = 1;
+    for (size_t i = 1; i < table->piece_count; i++) {
+        if (--first_length > 0 || d->pieces[i] == d->pieces[i - 1]) {
+            d->group_length[n]++;
+        } else {
+            d->group_length[++n] = 1;
+        }
+    }
+    d->group_length[++n] = 0;
+
+    //the groups are combined in the order the table gives, the leading group at order[0] and
+    //the other pawns at order[1], which have to be groups there are
+    bool pawns_on_both_sides = table->has_pawns && table->pawn_count[1] > 0;
+    if (order[0] >= n || (pawns_on_both_sides && (order[1] >= n || order[1] == order[0]))) {
+        return false;
+    }
+    int32_t next = pawns_on_both_sides ? 2 : 1;
+    int32_t free_squares = 64 - d->group_length[0] - (pawns_on_both_sides ? d->group_length[1] : 0);
+    uint64_t index = 1;
+    for (int32_t k = 0; next < n || k == order[0] || k == order[1]; k++) {
+        if (k == order[0]) {
+            d->group_index[0] = index;
+            index *= table->has_pawns ? LEAD_PAWNS_SIZE[d->group_length[0]][file]
+                : table->has_unique_pieces ? 31332 : 462;
+        } else if (k == order[1]) {
+            d->group_index[1] = index;
+            index *= BINOMIAL[d->group_length[1]][48 - d->group_length[0]];
+        } else {
+            d->group_index[next] = index;
+            index *= BINOMIAL[d->group_length[next]][free_squares];
+            free_squares -= d->group_length[next++];
+        }
+    }
+    d->group_index[n] = index;
+    return true;
+}
+
+//the number of values minus one a symbol and the symbols it pairs expand to, false if a pair refers to a
+//symbol that doesn't exist or to one it's part of, or expands to more values than symbol_length holds
+static bool set_symbol_length(Syzygy::PairsData *d, uint16_t symbol, std::vector<Syzygy::SymbolState> *states) {
+    using namespace Syzygy;
+
+    (*states)[symbol] = Visiting;
+    uint16_t right = right_symbol(d, symbol);
+    if (right == LEAF_SYMBOL) {
+        d->symbol_length[symbol] = 0;
+        (*states)[symbol] = Visited;
+        return true;
+    }
+    uint16_t left = left_symbol(d, symbol);
+    for (uint16_t half : {left, right}) {
+        if (half >= d->symbol_count || (*states)[half] == Visiting) {
+            return false;
+        }
+        if ((*states)[half] == Unvisited && !set_symbol_length(d, half, states)) {
+            return false;
+        }
+    }
+    int32_t length = d->symbol_length[left] + d->symbol_length[right] + 1;
+    if (length > UINT8_MAX) {
+        return false;
+    }
+    d->symbol_length[symbol] = (uint8_t) length;
+    (*states)[symbol] = Visited;
+    return true;
+}
+
+//reads the sizes and the code of one table, nullptr if they don't fit in the file or can't be right
+static const uint8_t *set_sizes(Syzygy::Table *table, Syzygy::PairsData *d, const uint8_t *data, const uint8_t *end) {
+    using namespace Syzygy;
+
+    if (!fits(data, end, 1)) {
+        return nullptr;
+    }
+    d->flags = *data++;
+    if (d->flags & SingleValueFlag) {
+        d->block_count = 0;
+        d->span = 0;
+        d->block_length_size = 0;
+        d->sparse_index_size = 0;
+        if (!fits(data, end, 1)) {
+            return nullptr;
+        }
+        //the single value
+        d->min_symbol_length = *data++;
+        if (table->type == WdlTable && d->min_symbol_length >= WDL_VALUES) {
+            return nullptr;
+        }
+        return data;
+    }
+
+    //the last group index is the size of the table
+    size_t groups = std::find(d->group_length, d->group_length + MAX_PIECES, 0) - d->group_length;
+    uint64_t table_size = d->group_index[groups];
+
+    //block size, span, padding, block count and the longest and shortest code
+    if (!fits(data, end, 9)) {
+        return nullptr;
+    }
+    uint8_t block_size_bits = *data++;
+    uint8_t span_bits = *data++;
+    if (block_size_bits > MAX_BLOCK_SIZE_BITS || span_bits > MAX_SPAN_BITS) {
+        return nullptr;
+    }
+    d->block_size = 1ULL << block_size_bits;
+    d->span = 1ULL << span_bits;
+    d->sparse_index_size = (size_t) ((table_size + d->span - 1) / d->span);
+    uint8_t padding = *data++;
+    d->block_count = read_le32(data);
+    data += 4;
+    //padded so the sparse index never points past the end
+    d->block_length_size = d->block_count + padding;
+    d->max_symbol_length = *data++;
+    d->min_symbol_length = *data++;
+    if (d->min_symbol_length == 0 || d->min_symbol_length > d->max_symbol_length
+        || d->max_symbol_length > MAX_SYMBOL_LENGTH) {
+        return nullptr;
+    }
+    d->lowest_symbol = data;
+
+    //canonical huffman: longer codes have lower values, base64[i] is the lowest code of length
+    //min_symbol_length + i padded to 64 bits
+    d->base64.assign(d->max_symbol_length - d->min_symbol_length + 1, 0);
+    if (!fits(data, end, d->base64.size() * 2 + 2)) {
+        return nullptr;
+    }
+    for (int32_t i = (int32_t) d->base64.size() - 2; i >= 0; i--) {
+        d->base64[i] = (d->base64[i + 1] + read_le16(d->lowest_symbol + 2 * i)
+            - read_le16(d->lowest_symbol + 2 * (i + 1))) / 2;
+    }
+    for (size_t i = 0; i < d->base64.size(); i++) {
+        d->base64[i] <<= 64 - i - d->min_symbol_length;
+    }
+    data += d->base64.size() * 2;
+
+    //recursive pairing: every symbol stands for a value or for a pair of symbols
+    d->symbol_count = read_le16(data);
+    data += 2;
+    size_t tree_size = (size_t) d->symbol_count * 3 + (d->symbol_count & 1);
+    if (d->symbol_count == 0 || !fits(data, end, tree_size)) {
+        return nullptr;
+    }
+    d->symbol_length.assign(d->symbol_count, 0);
+    d->tree = data;
+    std::vector<SymbolState> states = std::vector<SymbolState>(d->symbol_count, Unvisited);
+    for (uint16_t symbol = 0; symbol < d->symbol_count; symbol++) {
+        if (states[symbol] == Unvisited && !set_symbol_length(d, symbol, &states)) {
+            return nullptr;
+        }
+        if (table->type == WdlTable && d->symbol_length[symbol] == 0 && left_symbol(d, symbol) >= WDL_VALUES) {
+            return nullptr;
+        }
+    }
+    return data + tree_size;
+}
+
+//nullptr if a map doesn't fit in the file
+static const uint8_t *set_dtz_map(Syzygy::Table *table, const uint8_t *data, const uint8_t *end, int32_t max_file) {
+    using namespace Syzygy;
+
+    table->map = data;
+    for (int32_t file = 0; file <= max_file; file++) {
+        PairsData *d = table->get(0, file);
+        if (!(d->flags & MappedFlag)) {
+            continue;
+        }
+        //16 bit maps are aligned
+        size_t width = d->flags & WideFlag ? 2 : 1;
+        size_t padding = width == 2 ? (data - table->map) & 1 : 0;
+        if (!fits(data, end, padding)) {
+            return nullptr;
+        }
+        data += padding;
+        for (size_t i = 0; i < 4; i++) {
+            //the number of values and then the values
+            if (!fits(data, end, width)) {
+                return nullptr;
+            }
+            uint16_t length = width == 2 ? read_le16(data) : *data;
+            size_t start = (size_t) (data - table->map) / width + 1;
+            if (!fits(data, end, width * (length + 1)) || start > UINT16_MAX) {
+                return nullptr;
+            }
+            d->map_index[i] = (uint16_t) start;
+            d->map_length[i] = length;
+            data += width * (length + 1);
+        }
+    }
+    size_t padding = (data - table->map) & 1;
+    return fits(data, end, padding) ? data + padding : nullptr;
+}
+
+//whether the pieces the header lists are the ones of the table's name, the leading pawns first and (with
+//pawns on both sides) the other pawns right after them, as the indexing takes them to be
+static bool has_table_pieces(Syzygy::Table *table, Syzygy::PairsData *d) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < table->piece_count; i++) {
+        int32_t piece_type = (d->pieces[i] & 7) - 1;
+        if (piece_type < Move::PieceType::Pawn || piece_type > Move::PieceType::King) {
+            return false;
+        }
+        key += 1ULL << (4 * ((d->pieces[i] >> 3) * 6 + piece_type));
+    }
+    if (key != table->key && key != table->key2) {
+        return false;
+    }
+    if (!table->has_pawns) {
+        return true;
+    }
+    uint8_t lead = d->pieces[0];
+    if (lead != piece_code(Move::Piece(Move::Color::White, Move::PieceType::Pawn))
+        && lead != piece_code(Move::Piece(Move::Color::Black, Move::PieceType::Pawn))) {
+        return false;
+    }
+    for (size_t i = 0; i < (size_t) table->pawn_count[0] + table->pawn_count[1]; i++) {
+        if (d->pieces[i] != (i < table->pawn_count[0] ? lead : lead ^ 8)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//reads the layout of a just mapped file, data starts after the magic number and end is the end of the file.
+//False if any part of the layout lies outside the file or can't be right, so a damaged file is never read
+static bool setup_table(Syzygy::Table *table, const uint8_t *data, const uint8_t *base, const uint8_t *end) {
+    using namespace Syzygy;
+
+    size_t sides = table->type == WdlTable && table->key != table->key2 ? 2 : 1;
+    int32_t max_file = table->has_pawns ? 3 : 0;
+    bool pawns_on_both_sides = table->has_pawns && table->pawn_count[1] > 0;
+
+    //a flags byte, then for each file the order of the groups and the pieces
+    size_t header_size = 1 + (max_file + 1) * ((pawns_on_both_sides ? 2 : 1) + table->piece_count);
+    if (!fits(data, end, header_size)) {
+        return false;
+    }
+    data++;
+    for (int32_t file = 0; file <= max_file; file++) {
+        int32_t order[2][2] = {
+            {*data & 0xF, pawns_on_both_sides ? *(data + 1) & 0xF : 0xF},
+            {*data >> 4, pawns_on_both_sides ? *(data + 1) >> 4 : 0xF}
+        };
+        data += 1 + (pawns_on_both_sides ? 1 : 0);
+        for (size_t k = 0; k < table->piece_count; k++, data++) {
+            for (size_t side = 0; side < sides; side++) {
+                table->get(side, file)->pieces[k] = side == 1 ? *data >> 4 : *data & 0xF;
+            }
+        }
+        for (size_t side = 0; side < sides; side++) {
+            PairsData *d = table->get(side, file);
+            if (!has_table_pieces(table, d) || !set_groups(table, d, order[side], file)) {
+                return false;
+            }
+        }
+    }
+
+    //offsets are aligned relative to the start of the mapping, which is page aligned
+    if (!fits(data, end, (data - base) & 1)) {
+        return false;
+    }
+    data += (data - base) & 1;
+    for (int32_t file = 0; file <= max_file; file++) {
+        for (size_t side = 0; side < sides; side++) {
+            data = set_sizes(table, table->get(side, file), data, end);
+            if (data == nullptr) {
+                return false;
+            }
+        }
+    }
+    if (table->type == DtzTable) {
+        data = set_dtz_map(table, data, end, max_file);
+        if (data == nullptr) {
+            return false;
+        }
+    }
+    for (int32_t file = 0; file <= max_file; file++) {
+        for (size_t side = 0; side < sides; side++) {
+            PairsData *d = table->get(side, file);
+            if (!fits(data, end, d->sparse_index_size * 6)) {
+                return false;
+            }
+            d->sparse_index = data;
+            data += d->sparse_index_size * 6;
+        }
+    }
+    for (int32_t file = 0; file <= max_file; file++) {
+        for (size_t side = 0; side < sides; side++) {
+            PairsData *d = table->get(side, file);
+            if (!fits(data, end, (size_t) d->block_length_size * 2)) {
+                return false;
+            }
+            d->block_length = data;
+            data += (size_t) d->block_length_size * 2;
+        }
+    }
+    for (int32_t file = 0; file <= max_file; file++) {
+        for (size_t side = 0; side < sides; side++) {
+            PairsData *d = table->get(side, file);
+            size_t aligned = ((size_t) (data - base) + 0x3F) & ~(size_t) 0x3F;
+            if (aligned > (size_t) (end - base)) {
+                return false;
+            }
+            data = base + aligned;
+            size_t data_size = (size_t) d->block_count * d->block_size;
+            if (!fits(data, end, data_size)) {
+                return false;
+            }
+            d->data = data;
+            d->data_end = end;
+            data += data_size;
+        }
+    }
+
+    //every block the sparse index points at has to be there. The walk from it along the block lengths is
+    //checked as it's made, looking at every length here would read the whole index of the big tables
+    for (int32_t file = 0; file <= max_file; file++) {
+        for (size_t side = 0; side < sides; side++) {
+            PairsData *d = table->get(side, file);
+            for (size_t k = 0; k < d->sparse_index_size; k++) {
+                if (read_le32(d->sparse_index + 6 * k) >= d->block_count) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+//maps the table's file on the first probe, from any thread
+static bool map_table(Syzygy::Table *table) {
+    using namespace Syzygy;
+
+    if (table->ready.load(std::memory_order_acquire)) {
+        return table->available;
+    }
+    std::lock_guard<std::mutex> lock(map_mutex);
+    if (table->ready.load(std::memory_order_relaxed)) {
+        return table->available;
+    }
+
+    std::string file_name = table->name + (table->type == WdlTable ? ".rtbw" : ".rtbz");
+    const uint8_t *magic = table->type == WdlTable ? WDL_MAGIC : DTZ_MAGIC;
+    for (const std::string &directory : directories) {
+        if (!table->file.open((std::filesystem::path(directory) / file_name).string())) {
+            continue;
+        }
+        //a table is the magic number, the header and 64 byte aligned blocks
+        if (table->file.size() % 64 != 16 || std::memcmp(table->file.data(), magic, 4) != 0) {
+            table->file.close();
+            continue;
+        }
+        //a file that doesn't hold what its header says is never read, as if it weren't there
+        if (!setup_table(table, table->file.data() + 4, table->file.data(), table->file.data() + table->file.size())) {
+            table->file.close();
+            continue;
+        }
+        table->available = true;
+        break;
+    }
+    table->ready.store(true, std::memory_order_release);
+    return table->available;
+}
+
+//finds the value at index in a table: locates its block through the sparse index, walks the block's
+//huffman codes to the symbol holding it and expands that symbol's pairs down to the value. Nullopt if the
+//walk leaves the blocks or the file, which only a damaged file can make it do
+static std::optional<int32_t> decompress_pairs(Syzygy::PairsData *d, uint64_t index) {
+    using namespace Syzygy;
+
+    if (d->flags & SingleValueFlag) {
+        return d->min_symbol_length;
+    }
+
+    //the sparse index entry k points at the value with index k * span + span / 2
+    uint64_t k = index / d->span;
+    if (k >= d->sparse_index_size) {
+        return std::nullopt;
+    }
+    uint32_t block = read_le32(d->sparse_index + 6 * k);
+    int64_t offset = read_le16(d->sparse_index + 6 * k + 4);
+    offset += (int64_t) (index % d->span) - (int64_t) (d->span / 2);
+    while (offset < 0) {
+        if (block == 0) {
+            return std::nullopt;
+        }
+        offset += read_le16(d->block_length + 2 * --block) + 1;
+    }
+    while (block < d->block_count && offset > read_le16(d->block_length + 2 * block)) {
+        offset -= read_le16(d->block_length + 2 * block++) + 1;
+    }
+
+    const uint8_t *pointer = d->data + (uint64_t) block * d->block_size;
+    if (block >= d->block_count || !fits(pointer, d->data_end, 8)) {
+        return std::nullopt;
+    }
+    uint64_t buffer = read_be64(pointer);
+    pointer += 8;
+    int32_t buffer_size = 64;
+    uint16_t symbol;
+    while (true) {
+        //the code's length (minus the shortest), found from the lowest code of each length
+        size_t length = 0;
+        while (buffer < d->base64[length]) {
+            length++;
+        }
+        symbol = (uint16_t) ((buffer - d->base64[length]) >> (64 - length - d->min_symbol_length));
+        symbol += read_le16(d->lowest_symbol + 2 * length);
+        if (symbol >= d->symbol_count) {
+            return std::nullopt;
+        }
+        if (offset < d->symbol_length[symbol] + 1) {
+            break;
+        }
+        offset -= d->symbol_length[symbol] + 1;
+        length += d->min_symbol_length;
+        buffer <<= length;
+        buffer_size -= (int32_t) length;
+        if (buffer_size <= 32) {
+            if (!fits(pointer, d->data_end, 4)) {
+                return std::nullopt;
+            }
+            buffer_size += 32;
+            buffer |= (uint64_t) read_be32(pointer) << (64 - buffer_size);
+            pointer += 4;
+        }
+    }
+
+    //the pairs of a symbol are adjacent values, so descend to the side holding offset
+    while (d->symbol_length[symbol] != 0) {
+        uint16_t left = left_symbol(d, symbol);
+        if (offset < d->symbol_length[left] + 1) {
+            symbol = left;
+        } else {
+            offset -= d->symbol_length[left] + 1;
+            symbol = right_symbol(d, symbol);
+        }
+    }
+    return left_symbol(d, symbol);
+}
+
+//dtz values are stored by frequency, the map turns them back into distances in plies. Nullopt for a value
+//past the end of its map
+static std::optional<int32_t> map_score(Syzygy::Table *table, int32_t file, int32_t value, Syzygy::WDL wdl) {
+    using namespace Syzygy;
+
+    if (table->type == WdlTable) {
+        return value - 2;
+    }
+
+    const int32_t WDL_MAP[] = {1, 3, 0, 2, 0};
+    PairsData *d = table->get(0, file);
+    if (d->flags & MappedFlag) {
+        int32_t segment = WDL_MAP[wdl + 2];
+        if (value < 0 || value >= d->map_length[segment]) {
+            return std::nullopt;
+        }
+        size_t index = d->map_index[segment] + value;
+        value = d->flags & WideFlag ? read_le16(table->map + 2 * index) : table->map[index];
+    }
+    if ((wdl == Win && !(d->flags & WinPliesFlag))
+        || (wdl == Loss && !(d->flags & LossPliesFlag))
+        || wdl == CursedWin
+        || wdl == BlessedLoss) {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+static bool pawns_before(int32_t a, int32_t b) {
+    return Syzygy::MAP_PAWNS[a] < Syzygy::MAP_PAWNS[b];
+}
+
+//turns the position into the table's index and looks it up. Tables are stored with the stronger side
+//as white, the leading piece in the a1-d1-d4 triangle (or the leading pawn on files a-d), so the position
+//is flipped into that form first
+static int32_t probe_table_index(
+    Board::Board *board, Syzygy::Table *table, uint64_t key, Syzygy::WDL wdl, Syzygy::ProbeState *state
+) {
+    using namespace Syzygy;
+
+    int32_t squares[MAX_PIECES];
+    uint8_t pieces[MAX_PIECES];
+    size_t size = 0;
+    size_t lead_pawn_count = 0;
+    int32_t table_file = 0;
+    bool black_to_move = board->current_player == Move::Color::Black;
+
+    //with the same pieces on both sides only white to move is stored
+    bool symmetric_black_to_move = table->key == table->key2 && black_to_move;
+    bool black_stronger = key != table->key;
+    bool flip = symmetric_black_to_move || black_stronger;
+    uint8_t flip_color = flip ? 8 : 0;
+    int32_t flip_squares = flip ? 56 : 0;
+    int32_t side_to_move = flip != black_to_move ? 1 : 0;
+
+    std::optional<Move::Color> lead_color = std::nullopt;
+    if (table->has_pawns) {
+        //the leading pawns come first, their color is the one of the first piece of the table
+        uint8_t lead = table->get(0, 0)->pieces[0] ^ flip_color;
+        lead_color = lead & 8 ? Move::Color::Black : Move::Color::White;
+        for (int32_t s = 0; s < 64; s++) {
+            if (board->board[s] == Move::Piece(lead_color.value(), Move::PieceType::Pawn)) {
+                squares[size++] = s ^ flip_squares;
+            }
+        }
+        lead_pawn_count = size;
+        std::swap(squares[0], *std::max_element(squares, squares + lead_pawn_count, pawns_before));
+        table_file = file_of(squares[0]);
+        if (table_file > 3) {
+            table_file = file_of(squares[0] ^ 7);
+        }
+    }
+
+    if (table->type == DtzTable) {
+        uint8_t flags = table->get(side_to_move, table_file)->flags;
+        if ((flags & SideToMoveFlag) != side_to_move && !(table->key == table->key2 && !table->has_pawns)) {
+            *state = ChangeSideToMove;
+            return 0;
+        }
+    }
+
+    for (int32_t s = 0; s < 64; s++) {
+        if (!board->board[s].has_value()) {
+            continue;
+        }
+        Move::Piece piece = board->board[s].value();
+        if (piece.piece_type == Move::PieceType::Pawn && lead_color.has_value() && piece.color == lead_color.value()) {
+            continue;
+        }
+        squares[size] = s ^ flip_squares;
+        pieces[size++] = piece_code(piece) ^ flip_color;
+    }
+
+    PairsData *d = table->get(side_to_move, table_file);
+
+    //put the pieces in the table's order
+    for (size_t i = lead_pawn_count; i + 1 < size; i++) {
+        for (size_t j = i + 1; j < size; j++) {
+            if (d->pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    if (file_of(squares[0]) > 3) {
+        for (size_t i = 0; i < size; i++) {
+            squares[i] ^= 7;
+        }
+    }
+
+    uint64_t index;
+    if (table->has_pawns) {
+        index = LEAD_PAWN_INDEX[lead_pawn_count][squares[0]];
+        std::stable_sort(squares + 1, squares + lead_pawn_count, pawns_before);
+        for (size_t i = 1; i < lead_pawn_count; i++) {
+            index += BINOMIAL[i][MAP_PAWNS[squares[i]]];
+        }
+    } else {
+        if (rank_of(squares[0]) > 3) {
+            for (size_t i = 0; i < size; i++) {
+                squares[i] ^= 56;
+            }
+        }
+        //the first piece of the leading group off the a1-h8 diagonal goes below it
+        for (int32_t i = 0; i < d->group_length[0]; i++) {
+            if (off_diagonal(squares[i]) == 0) {
+                continue;
+            }
+            if (off_diagonal(squares[i]) > 0) {
+                for (size_t j = i; j < size; j++) {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+            break;
+        }
+
+        if (table->has_unique_pieces) {
+            int32_t adjust1 = squares[1] > squares[0] ? 1 : 0;
+            int32_t adjust2 = (squares[2] > squares[0] ? 1 : 0) + (squares[2] > squares[1] ? 1 : 0);
+            if (off_diagonal(squares[0]) != 0) {
+                index = ((uint64_t) MAP_A1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            } else if (off_diagonal(squares[1]) != 0) {
+                index = (6 * 63 + rank_of(squares[0]) * 28 + MAP_B1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            } else if (off_diagonal(squares[2]) != 0) {
+                index = 6 * 63 * 62 + 4 * 28 * 62
+                    + rank_of(squares[0]) * 7 * 28
+                    + (rank_of(squares[1]) - adjust1) * 28
+                    + MAP_B1H1H7[squares[2]];
+            } else {
+                index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+                    + rank_of(squares[0]) * 7 * 6
+                    + (rank_of(squares[1]) - adjust1) * 6
+                    + (rank_of(squares[2]) - adjust2);
+            }
+        } else {
+            index = MAP_KK[MAP_A1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    //the other groups, each square counted among the squares the groups before it left free
+    index *= d->group_index[0];
+    int32_t *group_squares = squares + d->group_length[0];
+    bool remaining_pawns = table->has_pawns && table->pawn_count[1] > 0;
+    for (int32_t next = 1; d->group_length[next] != 0; next++) {
+        std::stable_sort(group_squares, group_squares + d->group_length[next]);
+        uint64_t n = 0;
+        for (int32_t i = 0; i < d->group_length[next]; i++) {
+            int32_t adjust = (int32_t) std::count_if(squares, group_squares, [&](int32_t s) {
+                return group_squares[i] > s;
+            });
+            n += BINOMIAL[i + 1][group_squares[i] - adjust - (remaining_pawns ? 8 : 0)];
+        }
+        remaining_pawns = false;
+        index += n * d->group_index[next];
+        group_squares += d->group_length[next];
+    }
+
+    std::optional<int32_t> value = decompress_pairs(d, index);
+    std::optional<int32_t> score = value.has_value() ? map_score(table, table_file, value.value(), wdl) : std::nullopt;
+    if (!score.has_value()) {
+        *state = Fail;
+        return 0;
+    }
+    return score.value();
+}
+
+static int32_t probe_table(Board::Board *board, Syzygy::TableType type, Syzygy::ProbeState *state, Syzygy::WDL wdl) {
+    using namespace Syzygy;
+
+    uint64_t key = board->material_key;
+    //two kings
+    if (key == (1ULL << (4 * Move::PieceType::King)) + (1ULL << (4 * (6 + Move::PieceType::King)))) {
+        return Draw;
+    }
+    auto it = tables_by_key.find(key);
+    if (it == tables_by_key.end()) {
+        *state = Fail;
+        return 0;
+    }
+    Table *table = type == WdlTable ? &it->second->wdl : &it->second->dtz;
+    if (!map_table(table)) {
+        *state = Fail;
+        return 0;
+    }
+    return probe_table_index(board, table, key, wdl, state);
+}
+
+static bool is_zeroing(Board::Board *board, Move::Move *move) {
+    return board->board[move->to].has_value() || board->board[move->from].value().piece_type == Move::PieceType::Pawn;
+}
+
+static bool is_capture(Board::Board *board, Move::Move *move) {
+    Move::Piece piece = board->board[move->from].value();
+    return board->board[move->to].has_value()
+        || (piece.piece_type == Move::PieceType::Pawn && move->from % 8 != move->to % 8);
+}
+
+//tables don't have to store the right value where a capture (or with zeroing, a pawn move) wins or draws,
+//so those moves are searched and the best of them and the stored value is the result
+static Syzygy::WDL search_wdl(Board::Board *board, Syzygy::ProbeState *state, bool zeroing) {
+    using namespace Syzygy;
+
+    WDL best = Loss;
+    std::vector<Move::Move> moves = MoveGenerator::generate_moves(board);
+    size_t searched = 0;
+    for (Move::Move &move : moves) {
+        bool is_pawn_move = board->board[move.from].value().piece_type == Move::PieceType::Pawn;
+        if (!is_capture(board, &move) && (!zeroing || !is_pawn_move)) {
+            continue;
+        }
+        searched += 1;
+        Move::Move played = move;
+        board->make_move(&played);
+        WDL value = (WDL) -search_wdl(board, state, false);
+        board->unmake_move(&played);
+        if (*state == Fail) {
+            return Draw;
+        }
+        if (value > best) {
+            best = value;
+            if (value >= Win) {
+                *state = ZeroingBestMove;
+                return value;
+            }
+        }
+    }
+
+    //with every move searched the stored value may be wrong (tables know nothing of en passant)
+    bool all_searched = searched > 0 && searched == moves.size();
+    WDL value;
+    if (all_searched) {
+        value = best;
+    } else {
+        value = (WDL) probe_table(board, WdlTable, state, Draw);
+        if (*state == Fail) {
+            return Draw;
+        }
+    }
+
+    if (best >= value) {
+        *state = best > Draw || all_searched ? ZeroingBestMove : Ok;
+        return best;
+    }
+    *state = Ok;
+    return value;
+}
+
+//the dtz a zeroing move leaves behind, which the tables can't store
+static int32_t dtz_before_zeroing(Syzygy::WDL wdl) {
+    using namespace Syzygy;
+
+    return wdl == Win ? 1
+        : wdl == CursedWin ? 101
+        : wdl == BlessedLoss ? -101
+        : wdl == Loss ? -1
+        : 0;
+}
+
+static int32_t search_dtz(Board::Board *board, Syzygy::ProbeState *state) {
+    using namespace Syzygy;
+
+    *state = Ok;
+    WDL wdl = search_wdl(board, state, true);
+    //dtz tables don't store draws
+    if (*state == Fail || wdl == Draw) {
+        return 0;
+    }
+    if (*state == ZeroingBestMove) {
+        return dtz_before_zeroing(wdl);
+    }
+
+    int32_t dtz = probe_table(board, DtzTable, state, wdl);
+    if (*state == Fail) {
+        return 0;
+    }
+    if (*state != ChangeSideToMove) {
+        return (dtz + (wdl == BlessedLoss || wdl == CursedWin ? 100 : 0)) * sign_of(wdl);
+    }
+
+    //the table stores the other side to move, so look one move ahead for the winning move with the smallest dtz
+    int32_t min_dtz = 0xFFFF;
+    for (Move::Move &move : MoveGenerator::generate_moves(board)) {
+        bool zeroing = is_zeroing(board, &move);
+        Move::Move played = move;
+        board->make_move(&played);
+        dtz = zeroing ? -dtz_before_zeroing(search_wdl(board, state, false)) : -search_dtz(board, state);
+        //a mating move
+        if (dtz == 1 && board->is_in_check(board->current_player) && MoveGenerator::generate_moves(board).empty()) {
+            min_dtz = 1;
+        }
+        if (!zeroing) {
+            dtz += sign_of(dtz);
+        }
+        if (dtz < min_dtz && sign_of(dtz) == sign_of(wdl)) {
+            min_dtz = dtz;
+        }
+        board->unmake_move(&played);
+        if (*state == Fail) {
+            return 0;
+        }
+    }
+    //no legal moves: checkmated
+    return min_dtz == 0xFFFF ? -1 : min_dtz;
+}
+
+static bool has_castling_rights(Board::Board *board) {
+    return board->can_white_kingside_castle || board->can_white_queenside_castle
+        || board->can_black_kingside_castle || board->can_black_queenside_castle;
+}
+
+size_t Syzygy::init(const std::string &paths) {
+    static bool indices_ready = false;
+    if (!indices_ready) {
+        init_indices();
+        indices_ready = true;
+    }
+
+    tables_by_key.clear();
+    tables.clear();
+    directories.clear();
+    largest = 0;
+    if (paths.empty() || paths == "<empty>") {
+        return 0;
+    }
+
+#ifdef _WIN32
+    const char separator = ';';
+#else
+    const char separator = ':';
+#endif
+    size_t start = 0;
+    while (start <= paths.size()) {
+        size_t end = std::min(paths.find(separator, start), paths.size());
+        if (end > start) {
+            directories.push_back(paths.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    for (const std::string &directory : directories) {
+        std::error_code error;
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory, error)) {
+            if (entry.path().extension() != ".rtbw") {
+                continue;
+            }
+            //like KRPvKN: each side starts with its king
+            std::string name = entry.path().stem().string();
+            size_t v = name.find('v');
+            if (v == std::string::npos || name.front() != 'K' || v + 1 >= name.size() || name[v + 1] != 'K'
+                || name.size() - 1 > MAX_PIECES) {
+                continue;
+            }
+            bool valid = true;
+            for (size_t i = 0; i < name.size(); i++) {
+                valid = valid && (i == v || (name[i] != 'v' && piece_type_from_char(name[i]).has_value()));
+            }
+            if (!valid) {
+                continue;
+            }
+
+            TablePair *pair = &tables.emplace_back(name);
+            if (tables_by_key.count(pair->wdl.key) != 0) {
+                //the same table in another directory
+                tables.pop_back();
+                continue;
+            }
+            tables_by_key[pair->wdl.key] = pair;
+            tables_by_key[pair->wdl.key2] = pair;
+            largest = std::max(largest, pair->wdl.piece_count);
+        }
+    }
+    return tables.size();
+}
+
+size_t Syzygy::max_pieces() {
+    return largest;
+}
+
+std::vector<std::string> Syzygy::table_names() {
+    std::vector<std::string> names = std::vector<std::string>();
+    for (TablePair &pair : tables) {
+        names.push_back(pair.wdl.name);
+    }
+    return names;
+}
+
+size_t Syzygy::piece_count(Board::Board *board) {
+    size_t count = 0;
+    for (Move::Index i = 0; i < 64; i++) {
+        count += board->board[i].has_value() ? 1 : 0;
+    }
+    return count;
+}
+
+std::optional<Syzygy::WDL> Syzygy::probe_wdl(Board::Board *board) {
+    if (has_castling_rights(board) || piece_count(board) > largest) {
+        return std::nullopt;
+    }
+    ProbeState state = Ok;
+    WDL wdl = search_wdl(board, &state, false);
+    if (state == Fail) {
+        return std::nullopt;
+    }
+    return wdl;
+}
+
+std::optional<int32_t> Syzygy::probe_dtz(Board::Board *board) {
+    if (has_castling_rights(board) || piece_count(board) > largest) {
+        return std::nullopt;
+    }
+    ProbeState state = Ok;
+    int32_t dtz = search_dtz(board, &state);
+    if (state == Fail) {
+        return std::nullopt;
+    }
+    return dtz;
+}
+
+std::optional<std::vector<Move::Move>> Syzygy::filter_root_moves(Board::Board *board) {
+    if (has_castling_rights(board) || piece_count(board) > largest) {
+        return std::nullopt;
+    }
+
+    std::vector<Move::Move> moves = MoveGenerator::generate_moves(board);
+    if (moves.empty()) {
+        return std::nullopt;
+    }
+    //plies already played towards the fifty-move rule, which the dtz of every move adds to
+    int32_t clock = (int32_t) board->moves_since_last_pawn_move_or_capture;
+    std::vector<int32_t> distances = std::vector<int32_t>();
+    for (Move::Move &move : moves) {
+        ProbeState state = Ok;
+        Move::Move played = move;
+        board->make_move(&played);
+        //dtz counted from the root
+        int32_t dtz;
+        if (board->moves_since_last_pawn_move_or_capture == 0) {
+            dtz = dtz_before_zeroing((WDL) -search_wdl(board, &state, false));
+        } else {
+            dtz = -search_dtz(board, &state);
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : 0;
+        }
+        if (dtz == 2 && board->is_in_check(board->current_player) && MoveGenerator::generate_moves(board).empty()) {
+            dtz = 1;
+        }
+        board->unmake_move(&played);
+        if (state == Fail) {
+            return std::nullopt;
+        }
+        //a result the clock runs out before is a fifty-move draw, which also covers the cursed wins and
+        //blessed losses. The bound leaves a ply spare, as a dtz can be one more than the shortest path
+        if (std::abs(dtz) + clock > (int32_t) Board::FIFTY_MOVE_RULE_PLIES - 1) {
+            dtz = 0;
+        }
+        distances.push_back(dtz);
+    }
+
+    //winning moves with the shortest dtz, else the drawing moves, else the losing moves that hold out longest
+    int32_t best = 0;
+    bool has_draw = false;
+    for (int32_t dtz : distances) {
+        has_draw = has_draw || dtz == 0;
+        if (dtz > 0 && (best <= 0 || dtz < best)) {
+            best = dtz;
+        } else if (dtz < 0 && best <= 0 && !has_draw && dtz < best) {
+            best = dtz;
+        }
+    }
+    if (best < 0 && has_draw) {
+        best = 0;
+    }
+
+    std::vector<Move::Move> kept = std::vector<Move::Move>();
+    for (size_t i = 0; i < moves.size(); i++) {
+        if (distances[i] == best) {
+            kept.push_back(moves[i]);
+        }
+    }
+    return kept;
+}
@@ -0,0 +1,47 @@
+#ifndef SYZYGY_H
+#define SYZYGY_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+
+//syzygy endgame tablebases: win/draw/loss (.rtbw) and distance to zeroing (.rtbz) tables, memory mapped on first use.
+//positions with castling rights are never in a table
+namespace Syzygy {
+    //the biggest tables that exist
+    const size_t MAX_PIECES = 7;
+
+    //from the point of view of the player to move. A cursed win is a win that takes more than 50 moves
+    //without a capture or pawn move, so it is drawn under the fifty-move rule, as is a blessed loss
+    enum WDL : int8_t {
+        Loss = -2,
+        BlessedLoss = -1,
+        Draw = 0,
+        CursedWin = 1,
+        Win = 2
+    };
+
+    //finds the tables in the directories of paths (separated by ':', or ';' on windows), replacing the ones
+    //found before, an empty path or <empty> removes them all. Returns the number of wdl tables found
+    size_t init(const std::string &paths);
+    //pieces (kings included) of the biggest table found, 0 if there are none
+    size_t max_pieces();
+    //the names of the wdl tables found, like KRPvKN
+    std::vector<std::string> table_names();
+    size_t piece_count(Board::Board *board);
+
+    //nullopt if the position isn't in a table that was found
+    std::optional<WDL> probe_wdl(Board::Board *board);
+    //plies to the next capture or pawn move with the best play, positive when winning and negative when losing
+    //(100 more for cursed wins and blessed losses), 0 for a draw
+    std::optional<int32_t> probe_dtz(Board::Board *board);
+    //the root moves that keep the best result in the least plies by dtz, and so make progress towards it,
+    //nullopt if not all of them could be probed. Results the board's halfmove clock runs out before count as draws
+    std::optional<std::vector<Move::Move>> filter_root_moves(Board::Board *board);
+};
+
+#endif
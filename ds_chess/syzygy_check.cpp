@@ -0,0 +1,383 @@
+#include "syzygy_check.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bitbase.h"
+#include "board.h"
+#include "move_generator.h"
+#include "syzygy.h"
+
+//tries at placing a table's pieces before giving up on a sample, most fail only by leaving a king in check
+const size_t PLACEMENT_ATTEMPTS = 100;
+
+static char piece_char(Move::Color color, char piece) {
+    return color == Move::Color::White ? piece : (char) (piece - 'A' + 'a');
+}
+
+//a legal position with the pieces of table name (like KRPvKN) on random squares, with the colors swapped if
+//swap_colors, nullopt if none was found
+static std::optional<Board::Board> random_position(const std::string &name, bool swap_colors, std::mt19937_64 *random) {
+    for (size_t attempt = 0; attempt < PLACEMENT_ATTEMPTS; attempt++) {
+        std::array<char, 64> squares = {};
+        Move::Color color = swap_colors ? Move::Color::Black : Move::Color::White;
+        bool placed = true;
+        for (char c : name) {
+            if (c == 'v') {
+                color = Move::swap(color);
+                continue;
+            }
+            //pawns can't stand on the first or last rank
+            std::uniform_int_distribution<size_t> square_distribution = c == 'P'
+                ? std::uniform_int_distribution<size_t>(8, 55)
+                : std::uniform_int_distribution<size_t>(0, 63);
+            size_t square = square_distribution(*random);
+            if (squares[square] != 0) {
+                placed = false;
+                break;
+            }
+            squares[square] = piece_char(color, c);
+        }
+        if (!placed) {
+            continue;
+        }
+
+        std::string fen = std::string();
+        for (size_t rank = 8; rank-- > 0;) {
+            size_t empty = 0;
+            for (size_t file = 0; file < 8; file++) {
+                char c = squares[rank * 8 + file];
+                if (c == 0) {
+                    empty += 1;
+                    continue;
+                }
+                if (empty > 0) {
+                    fen += (char) ('0' + empty);
+                    empty = 0;
+                }
+                fen += c;
+            }
+            if (empty > 0) {
+                fen += (char) ('0' + empty);
+            }
+            if (rank > 0) {
+                fen += '/';
+            }
+        }
+        fen += (*random)() % 2 == 0 ? " w - - 0 1" : " b - - 0 1";
+
+        Board::Board board = Board::Board();
+        if (!std::holds_alternative<Board::SuccessfulOperation>(board.set_fen(fen))) {
+            continue;
+        }
+        //the player who just moved can't be in check
+        if (board.is_in_check(Move::swap(board.current_player))) {
+            continue;
+        }
+        return board;
+    }
+    return std::nullopt;
+}
+
+static size_t table_piece_count(const std::string &name) {
+    return name.size() - 1;
+}
+
+static int32_t sign_of(int32_t value) {
+    return (value > 0) - (value < 0);
+}
+
+//whether wdl is what the best of the moves leads to. A non-zeroing move to a position lost only after
+//more than 100 plies turns a win into a cursed win (and a loss into a blessed one), so only the sign has to
+//match, and exactly when the best is already cursed or blessed
+static bool is_consistent(Syzygy::WDL wdl, Syzygy::WDL best) {
+    if (best == Syzygy::CursedWin || best == Syzygy::BlessedLoss) {
+        return wdl == best;
+    }
+    return sign_of(wdl) == sign_of(best);
+}
+
+//the value the moves of board lead to, nullopt if a position after one of them couldn't be probed
+static std::optional<Syzygy::WDL> best_move_wdl(Board::Board *board, std::vector<Move::Move> *moves) {
+    if (moves->empty()) {
+        return board->is_in_check(board->current_player) ? Syzygy::Loss : Syzygy::Draw;
+    }
+    Syzygy::WDL best = Syzygy::Loss;
+    for (Move::Move &move : *moves) {
+        Move::Move played = move;
+        board->make_move(&played);
+        std::optional<Syzygy::WDL> after = Syzygy::probe_wdl(board);
+        board->unmake_move(&played);
+        if (!after.has_value()) {
+            return std::nullopt;
+        }
+        best = std::max(best, (Syzygy::WDL) -after.value());
+    }
+    return best;
+}
+
+static bool is_zeroing(Board::Board *board, Move::Move *move) {
+    return board->board[move->to].has_value()
+        || board->board[move->from].value().piece_type == Move::PieceType::Pawn;
+}
+
+//dtz of board from its moves: the fewest plies to the next zeroing move when winning and the most when
+//losing, nullopt if a position after one of the moves couldn't be probed
+static std::optional<int32_t> best_move_dtz(Board::Board *board, std::vector<Move::Move> *moves, Syzygy::WDL wdl) {
+    std::optional<int32_t> best = std::nullopt;
+    for (Move::Move &move : *moves) {
+        bool zeroing = is_zeroing(board, &move);
+        Move::Move played = move;
+        board->make_move(&played);
+        std::optional<Syzygy::WDL> after_wdl = Syzygy::probe_wdl(board);
+        std::optional<int32_t> after_dtz = zeroing ? std::optional<int32_t>(0) : Syzygy::probe_dtz(board);
+        bool mated = board->is_in_check(board->current_player) && MoveGenerator::generate_moves(board).empty();
+        board->unmake_move(&played);
+        if (!after_wdl.has_value() || !after_dtz.has_value()) {
+            return std::nullopt;
+        }
+
+        Syzygy::WDL result = (Syzygy::WDL) -after_wdl.value();
+        if (wdl > Syzygy::Draw && result == wdl) {
+            //a zeroing move (or mate) ends the count
+            int32_t plies = zeroing || mated ? 1 : std::abs(after_dtz.value()) + 1;
+            best = std::min(best.value_or(plies), plies);
+        } else if (wdl < Syzygy::Draw) {
+            int32_t plies = zeroing ? 1 : std::abs(after_dtz.value()) + 1;
+            best = std::max(best.value_or(plies), plies);
+        }
+    }
+    return best;
+}
+
+//plies until mate with the best play for both sides: odd when the player to move mates, even when it is
+//mated (0 if it already is), nullopt if neither happens within max_plies
+static std::optional<int32_t> mate_distance(Board::Board *board, int32_t max_plies) {
+    std::vector<Move::Move> moves = MoveGenerator::generate_moves(board);
+    if (moves.empty()) {
+        return board->is_in_check(board->current_player) ? std::optional<int32_t>(0) : std::nullopt;
+    }
+    if (max_plies == 0) {
+        return std::nullopt;
+    }
+
+    std::optional<int32_t> fastest_win = std::nullopt;
+    int32_t slowest_loss = 0;
+    bool every_move_loses = true;
+    for (Move::Move &move : moves) {
+        Move::Move played = move;
+        board->make_move(&played);
+        std::optional<int32_t> after = mate_distance(board, max_plies - 1);
+        board->unmake_move(&played);
+        if (after.has_value() && after.value() % 2 == 0) {
+            fastest_win = std::min(fastest_win.value_or(after.value() + 1), after.value() + 1);
+        } else if (after.has_value()) {
+            slowest_loss = std::max(slowest_loss, after.value() + 1);
+        } else {
+            every_move_loses = false;
+        }
+    }
+    if (fastest_win.has_value()) {
+        return fastest_win;
+    }
+    return every_move_loses ? std::optional<int32_t>(slowest_loss) : std::nullopt;
+}
+
+static void add_table(SyzygyCheck::Result *result, SyzygyCheck::TableResult *table) {
+    result->positions += table->positions;
+    result->mismatches += table->mismatches;
+    result->tables.push_back(*table);
+}
+
+SyzygyCheck::Result SyzygyCheck::check_wdl(size_t max_pieces, size_t samples, uint64_t seed) {
+    Result result = Result {0, 0, {}};
+    std::mt19937_64 random = std::mt19937_64(seed);
+    for (const std::string &name : Syzygy::table_names()) {
+        if (table_piece_count(name) > max_pieces) {
+            continue;
+        }
+        TableResult table = TableResult {name, 0, 0};
+        for (size_t i = 0; i < samples; i++) {
+            std::optional<Board::Board> board = random_position(name, i % 2 == 1, &random);
+            if (!board.has_value()) {
+                continue;
+            }
+            std::optional<Syzygy::WDL> wdl = Syzygy::probe_wdl(&board.value());
+            std::vector<Move::Move> moves = MoveGenerator::generate_moves(&board.value());
+            std::optional<Syzygy::WDL> best = best_move_wdl(&board.value(), &moves);
+            if (!wdl.has_value() || !best.has_value()) {
+                continue;
+            }
+            table.positions += 1;
+            if (!is_consistent(wdl.value(), best.value())) {
+                table.mismatches += 1;
+            }
+        }
+        add_table(&result, &table);
+    }
+    return result;
+}
+
+SyzygyCheck::Result SyzygyCheck::check_dtz(size_t max_pieces, size_t samples, uint64_t seed) {
+    Result result = Result {0, 0, {}};
+    std::mt19937_64 random = std::mt19937_64(seed);
+    for (const std::string &name : Syzygy::table_names()) {
+        if (table_piece_count(name) > max_pieces) {
+            continue;
+        }
+        TableResult table = TableResult {name, 0, 0};
+        for (size_t i = 0; i < samples; i++) {
+            std::optional<Board::Board> board = random_position(name, i % 2 == 1, &random);
+            if (!board.has_value()) {
+                continue;
+            }
+            std::optional<Syzygy::WDL> wdl = Syzygy::probe_wdl(&board.value());
+            std::optional<int32_t> dtz = Syzygy::probe_dtz(&board.value());
+            std::vector<Move::Move> moves = MoveGenerator::generate_moves(&board.value());
+            if (!wdl.has_value() || !dtz.has_value() || moves.empty()) {
+                continue;
+            }
+            if (wdl.value() == Syzygy::Draw) {
+                table.positions += 1;
+                table.mismatches += dtz.value() != 0 ? 1 : 0;
+                continue;
+            }
+            std::optional<int32_t> best = best_move_dtz(&board.value(), &moves, wdl.value());
+            if (!best.has_value()) {
+                continue;
+            }
+            table.positions += 1;
+            if (sign_of(dtz.value()) != sign_of(wdl.value()) || std::abs(std::abs(dtz.value()) - best.value()) > 1) {
+                table.mismatches += 1;
+            }
+        }
+        add_table(&result, &table);
+    }
+    return result;
+}
+
+SyzygyCheck::Result SyzygyCheck::check_bitbases(size_t samples, uint64_t seed) {
+    Bitbase::init(std::max(1u, std::thread::hardware_concurrency()));
+
+    Result result = Result {0, 0, {}};
+    std::mt19937_64 random = std::mt19937_64(seed);
+    std::vector<std::string> names = Syzygy::table_names();
+    for (const std::string name : {"KPvK", "KRvK", "KQvK", "KBNvK"}) {
+        if (std::find(names.begin(), names.end(), name) == names.end()) {
+            continue;
+        }
+        TableResult table = TableResult {name, 0, 0};
+        for (size_t i = 0; i < samples; i++) {
+            std::optional<Board::Board> board = random_position(name, i % 2 == 1, &random);
+            if (!board.has_value()) {
+                continue;
+            }
+            std::optional<Syzygy::WDL> wdl = Syzygy::probe_wdl(&board.value());
+            std::optional<Bitbase::Probe> probe = Bitbase::probe(&board.value());
+            if (!wdl.has_value() || !probe.has_value()) {
+                continue;
+            }
+            Syzygy::WDL expected = !probe.value().win ? Syzygy::Draw
+                : probe.value().strong_side == board.value().current_player ? Syzygy::Win
+                : Syzygy::Loss;
+            table.positions += 1;
+            table.mismatches += wdl.value() != expected ? 1 : 0;
+        }
+        add_table(&result, &table);
+    }
+    return result;
+}
+
+SyzygyCheck::Result SyzygyCheck::check_mates(size_t samples, uint64_t seed) {
+    Result result = Result {0, 0, {}};
+    std::mt19937_64 random = std::mt19937_64(seed);
+    std::vector<std::string> names = Syzygy::table_names();
+    for (const std::string name : {"KRvK", "KQvK"}) {
+        if (std::find(names.begin(), names.end(), name) == names.end()) {
+            continue;
+        }
+        TableResult table = TableResult {name, 0, 0};
+        for (size_t i = 0; i < samples; i++) {
+            std::optional<Board::Board> board = random_position(name, i % 2 == 1, &random);
+            if (!board.has_value() || MoveGenerator::generate_moves(&board.value()).empty()) {
+                continue;
+            }
+            std::optional<Syzygy::WDL> wdl = Syzygy::probe_wdl(&board.value());
+            std::optional<int32_t> dtz = Syzygy::probe_dtz(&board.value());
+            if (!wdl.has_value() || !dtz.has_value() || dtz.value() == 0 || std::abs(dtz.value()) > MATE_CHECK_PLIES - 1) {
+                continue;
+            }
+            //a dtz of n may stand for n or n + 1 plies
+            std::optional<int32_t> mate = mate_distance(&board.value(), MATE_CHECK_PLIES);
+            table.positions += 1;
+            if (
+                !mate.has_value()
+                || (mate.value() % 2 == 1) != (dtz.value() > 0)
+                || (mate.value() != std::abs(dtz.value()) && mate.value() != std::abs(dtz.value()) + 1)
+            ) {
+                table.mismatches += 1;
+            }
+        }
+        add_table(&result, &table);
+    }
+    return result;
+}
+
+bool SyzygyCheck::checked_every_table(Result *result) {
+    return std::all_of(result->tables.begin(), result->tables.end(), [](TableResult &table) {
+        return table.positions > 0;
+    });
+}
+
+bool SyzygyCheck::verify_command(StringHandling::Tokenizer *tokens) {
+    if (!tokens->has_next()) {
+        std::cout << "usage: ds_chess verify-syzygy <path> [samples <n>]" << std::endl;
+        return false;
+    }
+    std::string path = std::string(tokens->next());
+    size_t samples = DEFAULT_VERIFY_SAMPLES;
+    while (tokens->has_next()) {
+        std::string_view token = tokens->next();
+        if (token == "samples" && tokens->has_next()) {
+            samples = (size_t) std::max<int64_t>(1, StringHandling::to_int(tokens->next()));
+        }
+    }
+
+    size_t found = Syzygy::init(path);
+    std::cout << "Tables found   : " << found << std::endl;
+    if (found == 0) {
+        return false;
+    }
+
+    //fixed seeds, so a failure can be reproduced. Every table is probed by the move checks, so each has to
+    //give them positions, while only some positions are close enough to mate for the mate check
+    struct Check {
+        const char *name;
+        Result result;
+        bool needs_every_table;
+    };
+    std::vector<Check> checks = {
+        Check {"wdl moves", check_wdl(Syzygy::MAX_PIECES, samples, 1), true},
+        Check {"dtz moves", check_dtz(Syzygy::MAX_PIECES, samples, 2), true},
+        Check {"bitbases", check_bitbases(samples, 3), true},
+        Check {"mates", check_mates(samples, 4), false},
+    };
+    bool passed = true;
+    for (Check &check : checks) {
+        std::cout << check.name << " : " << check.result.positions << " positions, "
+            << check.result.mismatches << " mismatches" << std::endl;
+        for (TableResult &table : check.result.tables) {
+            bool unchecked = check.needs_every_table && table.positions == 0;
+            std::cout << "  " << table.name << " : " << table.positions << " positions, "
+                << table.mismatches << " mismatches" << (unchecked ? ", could not be probed" : "") << std::endl;
+        }
+        passed = passed && check.result.mismatches == 0 && (!check.needs_every_table || checked_every_table(&check.result));
+    }
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed;
+}
@@ -0,0 +1,56 @@
+#ifndef SYZYGY_CHECK_H
+#define SYZYGY_CHECK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "string_handling.h"
+
+//checks of the syzygy tables found by Syzygy::init. A decoding or indexing mistake gives wrong values that
+//look like any other, so the values are checked against what the positions' moves lead to and against the
+//bitbases rather than trusted
+namespace SyzygyCheck {
+    //the tables the uci loop checks as soon as they're found, before the search may use any of them.
+    //The small tables take every indexing path but are quick to map and probe
+    const size_t LOAD_CHECK_MAX_PIECES = 4;
+    const size_t LOAD_CHECK_SAMPLES = 64;
+    //per table, used when verify-syzygy is given no sample count
+    const size_t DEFAULT_VERIFY_SAMPLES = 2000;
+    //dtz is compared with a mate search in the bare king tables where the mate is at most this many plies away
+    const int32_t MATE_CHECK_PLIES = 4;
+
+    struct TableResult {
+        std::string name;
+        size_t positions;
+        size_t mismatches;
+    };
+
+    //the totals and what each table the check looked at gave
+    struct Result {
+        size_t positions;
+        size_t mismatches;
+        std::vector<TableResult> tables;
+    };
+
+    //random positions of every table of at most max_pieces pieces, each of which has to agree with the positions
+    //its moves lead to: a win needs a move to a lost position and a loss every move to lead to a won one
+    Result check_wdl(size_t max_pieces, size_t samples, uint64_t seed);
+    //the same positions, where dtz has to be one more than that of the best move (or 1 for a winning zeroing
+    //move), give or take the ply the tables may round by
+    Result check_dtz(size_t max_pieces, size_t samples, uint64_t seed);
+    //wdl of KPvK, KRvK, KQvK and KBNvK against the bitbases, which are generated first if they aren't yet
+    Result check_bitbases(size_t samples, uint64_t seed);
+    //dtz of KQvK and KRvK positions close to mate against the exact distance to mate, which is the dtz as
+    //nothing can be captured and there are no pawns
+    Result check_mates(size_t samples, uint64_t seed);
+
+    //false if a table the check looked at had no position checked, which is what a table that can't be read
+    //gives. The checks pass over such a table rather than fail, as they can only compare what was probed
+    bool checked_every_table(Result *result);
+
+    //verify-syzygy <path> [samples <n>]: every check over every table found in path, false if any disagrees
+    bool verify_command(StringHandling::Tokenizer *tokens);
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "time_manager.h"
+
+#include <algorithm>
+
+#include "trace.h"
+
+TimeManager::TimeManager::TimeManager(TimeControl time_control) :
+    start(std::chrono::steady_clock::now()),
+    infinite(time_control.infinite),
+    pondering(time_control.ponder),
+    stop_requested(false),
+    time_control(time_control),
+    limit_start(0),
+    timed(false),
+    base_soft_limit(0),
+    soft_limit(0),
+    hard_limit(0)
+{
+    //a ponder search only gets its limits once the opponent plays the expected move
+    if (time_control.infinite || time_control.ponder) {
+        return;
+    }
+    this->set_limits();
+}
+
+void TimeManager::TimeManager::set_limits() {
+    if (this->time_control.move_time.has_value()) {
+        this->timed = true;
+        this->base_soft_limit = std::max<int64_t>(1, this->time_control.move_time.value() - MOVE_OVERHEAD);
+        this->soft_limit = this->base_soft_limit;
+        this->hard_limit = this->base_soft_limit;
+        return;
+    }
+
+    if (!this->time_control.time_left.has_value()) {
+        return;
+    }
+
+    int64_t time_left = std::max<int64_t>(1, this->time_control.time_left.value() - MOVE_OVERHEAD);
+    int32_t moves_to_go = std::max(1, this->time_control.moves_to_go.value_or(DEFAULT_MOVES_TO_GO));
+
+    this->timed = true;
+    this->base_soft_limit = std::min(time_left, time_left / moves_to_go + this->time_control.increment * 3 / 4);
+    this->base_soft_limit = std::max<int64_t>(1, this->base_soft_limit);
+    this->soft_limit = this->base_soft_limit;
+    this->hard_limit = std::min(
+        (int64_t) (this->base_soft_limit * HARD_LIMIT_FACTOR),
+        (int64_t) (time_left * MAX_TIME_FRACTION)
+    );
+    this->hard_limit = std::max(this->hard_limit, this->soft_limit);
+}
+
+int64_t TimeManager::TimeManager::elapsed() const {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - this->start).count();
+}
+
+bool TimeManager::TimeManager::is_timed() const {
+    return this->timed;
+}
+
+bool TimeManager::TimeManager::should_start_iteration() const {
+    //the next iteration usually takes longer than all of the previous ones together,
+    //so don't start one that is unlikely to finish before the soft limit
+    if (this->stop_requested) {
+        return false;
+    }
+    if (this->pondering) {
+        return true;
+    }
+    return !this->timed || this->elapsed() - this->limit_start < this->soft_limit / 2;
+}
+
+bool TimeManager::TimeManager::should_stop() const {
+    if (this->stop_requested) {
+        return true;
+    }
+    return !this->pondering && this->timed && this->elapsed() - this->limit_start >= this->hard_limit;
+}
+
+void TimeManager::TimeManager::on_fail_low() {
+    if (this->pondering || !this->timed) {
+        return;
+    }
+    this->soft_limit = std::min(
+        this->hard_limit,
+        this->soft_limit + (int64_t) (this->base_soft_limit * FAIL_LOW_EXTENSION)
+    );
+    Trace::instant("extend soft limit", "time", {{"soft_limit", (double) this->soft_limit}});
+}
+
+
+void TimeManager::TimeManager::stop() {
+    Trace::instant("stop", "time");
+    std::lock_guard<std::mutex> lock(this->stop_mutex);
+    this->stop_requested = true;
+    this->stop_condition.notify_all();
+}
+
+void TimeManager::TimeManager::ponderhit() {
+    std::lock_guard<std::mutex> lock(this->stop_mutex);
+    if (!this->pondering) {
+        return;
+    }
+    //the opponent played the expected move, from now on the search runs on our own clock
+    this->limit_start = this->elapsed();
+    this->set_limits();
+    Trace::instant("ponderhit", "time", {
+        {"soft_limit", (double) this->soft_limit}, {"hard_limit", (double) this->hard_limit}
+    });
+    //publishes the limits to the search thread
+    this->pondering = false;
+    this->stop_condition.notify_all();
+}
+
+void TimeManager::TimeManager::wait_for_stop() {
+    std::unique_lock<std::mutex> lock(this->stop_mutex);
+    this->stop_condition.wait(lock, [this] {
+        return this->stop_requested || (!this->infinite && !this->pondering);
+    });
+}
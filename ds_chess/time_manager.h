@@ -0,0 +1,73 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace TimeManager {
+    //moves assumed to be left in the game when the gui doesn't send movestogo
+    const int32_t DEFAULT_MOVES_TO_GO = 30;
+    //milliseconds kept in reserve for gui and communication lag
+    const int64_t MOVE_OVERHEAD = 30;
+    //the hard limit is this many times the soft limit, but never more than MAX_TIME_FRACTION of the clock
+    const double HARD_LIMIT_FACTOR = 4.0;
+    const double MAX_TIME_FRACTION = 0.5;
+    //fraction of the original soft limit added each time an iteration fails low
+    const double FAIL_LOW_EXTENSION = 0.5;
+
+    //clock information for the player to move, all times in milliseconds
+    struct TimeControl {
+        std::optional<int64_t> time_left = std::nullopt;
+        int64_t increment = 0;
+        std::optional<int32_t> moves_to_go = std::nullopt;
+        std::optional<int64_t> move_time = std::nullopt;
+        //search until the gui sends stop, ignoring everything else
+        bool infinite = false;
+        //search on the opponent's time, the clock only applies after ponderhit
+        bool ponder = false;
+    };
+
+    class TimeManager {
+    public:
+        TimeManager(TimeControl time_control);
+        //milliseconds since the search started
+        int64_t elapsed() const;
+        //false if nothing limits the search by time
+        bool is_timed() const;
+        //checked between iterations: is there enough time left to start (and likely finish) another one
+        bool should_start_iteration() const;
+        //checked during search: the search must stop immediately
+        bool should_stop() const;
+        //the root failed low, so the best move is in doubt and it's worth spending more time
+        void on_fail_low();
+        //called from the uci thread: the search must stop as soon as possible
+        void stop();
+        //called from the uci thread: the ponder move was played, turn the search into a timed one
+        void ponderhit();
+        //an infinite or ponder search that ran out of depth blocks here until it is stopped or hit
+        void wait_for_stop();
+    private:
+        //computes the limits from the time control
+        void set_limits();
+
+        std::chrono::steady_clock::time_point start;
+        bool infinite;
+        std::atomic<bool> pondering;
+        std::atomic<bool> stop_requested;
+        std::mutex stop_mutex;
+        std::condition_variable stop_condition;
+        TimeControl time_control;
+        //milliseconds after start from which the limits count, later than 0 after a ponderhit
+        int64_t limit_start;
+        bool timed;
+        int64_t base_soft_limit;
+        int64_t soft_limit;
+        int64_t hard_limit;
+    };
+};
+
+#endif
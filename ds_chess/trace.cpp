@@ -0,0 +1,121 @@
+#include "trace.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+std::atomic<bool> Trace::tracing = false;
+
+static std::mutex trace_mutex;
+static std::ofstream trace_file;
+static std::chrono::steady_clock::time_point trace_start;
+static std::atomic<int32_t> next_thread_id = 0;
+static thread_local int32_t thread_id = ++next_thread_id;
+
+static int64_t now() {
+    auto elapsed = std::chrono::steady_clock::now() - trace_start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+static std::string format_args(std::initializer_list<Trace::Arg> args) {
+    std::ostringstream out;
+    bool first = true;
+    for (const Trace::Arg &arg : args) {
+        out << (first ? "" : ",") << "\"" << arg.name << "\":";
+        //json has no infinity, which open aspiration windows use
+        if (std::isfinite(arg.value)) {
+            out << arg.value;
+        } else {
+            out << (arg.value > 0 ? "\"inf\"" : "\"-inf\"");
+        }
+        first = false;
+    }
+    return out.str();
+}
+
+//the json array format, where every event is followed by a comma and the closing bracket is optional
+static void write_event(const std::string &event) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (trace_file.is_open()) {
+        trace_file << event << ",\n";
+    }
+}
+
+void Trace::open(const std::string &path) {
+    close();
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    trace_file.open(path, std::ios::out | std::ios::trunc);
+    if (!trace_file.is_open()) {
+        return;
+    }
+    trace_start = std::chrono::steady_clock::now();
+    trace_file << "[\n";
+    tracing = true;
+}
+
+void Trace::close() {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    tracing = false;
+    if (!trace_file.is_open()) {
+        return;
+    }
+    //an empty metadata event takes the place of the last event's trailing comma
+    trace_file << "{\"name\":\"trace end\",\"ph\":\"M\",\"pid\":1,\"tid\":0}\n]\n";
+    trace_file.close();
+}
+
+void Trace::flush() {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    trace_file.flush();
+}
+
+void Trace::name_thread(const char *name) {
+    if (!enabled()) {
+        return;
+    }
+    std::ostringstream event;
+    event << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread_id
+        << ",\"args\":{\"name\":\"" << name << "\"}}";
+    write_event(event.str());
+}
+
+void Trace::instant(const char *name, const char *category, std::initializer_list<Arg> args) {
+    if (!enabled()) {
+        return;
+    }
+    std::ostringstream event;
+    event << "{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"i\",\"s\":\"t\""
+        << ",\"ts\":" << now() << ",\"pid\":1,\"tid\":" << thread_id
+        << ",\"args\":{" << format_args(args) << "}}";
+    write_event(event.str());
+}
+
+Trace::Scope::Scope(const char *name, const char *category, std::initializer_list<Arg> args) :
+    name(name),
+    category(category),
+    args(),
+    start(-1)
+{
+    if (!enabled()) {
+        return;
+    }
+    this->args = format_args(args);
+    this->start = now();
+}
+
+Trace::Scope::~Scope() {
+    if (this->start < 0 || !enabled()) {
+        return;
+    }
+    std::ostringstream event;
+    event << "{\"name\":\"" << this->name << "\",\"cat\":\"" << this->category << "\",\"ph\":\"X\""
+        << ",\"ts\":" << this->start << ",\"dur\":" << now() - this->start
+        << ",\"pid\":1,\"tid\":" << thread_id
+        << ",\"args\":{" << this->args << "}}";
+    write_event(event.str());
+}
@@ -0,0 +1,51 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+//timeline of the search in chrome's trace event format, viewable in chrome://tracing or perfetto.
+//only coarse events are traced (threads, iterations, aspiration windows, time manager decisions),
+//and while no trace file is open every call returns after checking a single flag
+namespace Trace {
+    struct Arg {
+        const char *name;
+        double value;
+    };
+
+    extern std::atomic<bool> tracing;
+
+    inline bool enabled() {
+        return tracing.load(std::memory_order_relaxed);
+    }
+
+    //starts a new trace in path, closing the current one
+    void open(const std::string &path);
+    //writes out the end of the trace, which stays viewable even if this never happens
+    void close();
+    //makes the events so far visible in the file, called after every search
+    void flush();
+    //names the calling thread in the timeline
+    void name_thread(const char *name);
+    //an event without duration, such as a time manager decision
+    void instant(const char *name, const char *category, std::initializer_list<Arg> args = {});
+
+    //an event lasting from construction to destruction
+    class Scope {
+    public:
+        Scope(const char *name, const char *category, std::initializer_list<Arg> args = {});
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    private:
+        const char *name;
+        const char *category;
+        std::string args;
+        //microseconds since the trace was opened, negative while tracing is off
+        int64_t start;
+    };
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "transposition_table.h"
+
+#include <algorithm>
+
+TranspositionTable::TranspositionTable::TranspositionTable(size_t size_mb) :
+    entries(std::vector<Entry>())
+{
+    this->resize(size_mb);
+}
+
+void TranspositionTable::TranspositionTable::resize(size_t size_mb) {
+    size_mb = std::clamp(size_mb, MIN_SIZE_MB, MAX_SIZE_MB);
+    size_t count = size_mb * 1024 * 1024 / sizeof(Entry);
+    this->entries = std::vector<Entry>(count, Entry {0, 0.0, 0, Bound::Exact, 0});
+}
+
+void TranspositionTable::TranspositionTable::clear() {
+    std::fill(this->entries.begin(), this->entries.end(), Entry {0, 0.0, 0, Bound::Exact, 0});
+}
+
+std::optional<TranspositionTable::Entry> TranspositionTable::TranspositionTable::probe(uint64_t key) const {
+    const Entry &entry = this->entries[key % this->entries.size()];
+    if (entry.key != key) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+void TranspositionTable::TranspositionTable::store(
+    uint64_t key, float score, int32_t depth, Bound bound, std::optional<Move::Move> move
+) {
+    Entry &entry = this->entries[key % this->entries.size()];
+    //keep deeper results for the same position unless the new one is exact
+    if (entry.key == key && depth < entry.depth && bound != Bound::Exact) {
+        return;
+    }
+    uint16_t packed_move = move.has_value() ? pack_move(&move.value()) : 0;
+    //a search that didn't find a best move shouldn't erase the one already known
+    if (entry.key == key && packed_move == 0) {
+        packed_move = entry.move;
+    }
+    entry = Entry {key, score, (int16_t) depth, bound, packed_move};
+}
+
+uint16_t TranspositionTable::pack_move(Move::Move *move) {
+    //bits 0-5 from, 6-11 to, 12-14 promotion piece type + 1 (0 for no promotion)
+    uint16_t promotion = move->promotion.has_value() ? move->promotion.value().piece_type + 1 : 0;
+    return (uint16_t) (move->from | (move->to << 6) | (promotion << 12));
+}
+
+std::optional<Move::Move> TranspositionTable::unpack_move(uint16_t packed, Move::Color color) {
+    if (packed == 0) {
+        return std::nullopt;
+    }
+    Move::Index from = packed & 63;
+    Move::Index to = (packed >> 6) & 63;
+    uint16_t promotion = (packed >> 12) & 7;
+    if (promotion == 0) {
+        return Move::Move(from, to, std::nullopt, std::nullopt);
+    }
+    return Move::Move(from, to, std::nullopt, Move::Piece(color, (Move::PieceType) (promotion - 1)));
+}
@@ -0,0 +1,50 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "move.h"
+
+namespace TranspositionTable {
+    const size_t DEFAULT_SIZE_MB = 16;
+    const size_t MIN_SIZE_MB = 1;
+    const size_t MAX_SIZE_MB = 4096;
+
+    enum Bound : uint8_t {
+        //the score is exact
+        Exact,
+        //the search failed high, the real score is at least the stored one
+        Lower,
+        //the search failed low, the real score is at most the stored one
+        Upper
+    };
+
+    struct Entry {
+        uint64_t key;
+        float score;
+        int16_t depth;
+        Bound bound;
+        //best (or refuting) move packed by pack_move, 0 if there is none
+        uint16_t move;
+    };
+
+    class TranspositionTable {
+    public:
+        TranspositionTable(size_t size_mb);
+        //reallocates the table, which also clears it
+        void resize(size_t size_mb);
+        void clear();
+        std::optional<Entry> probe(uint64_t key) const;
+        void store(uint64_t key, float score, int32_t depth, Bound bound, std::optional<Move::Move> move);
+    private:
+        std::vector<Entry> entries;
+    };
+
+    uint16_t pack_move(Move::Move *move);
+    //the color is needed to rebuild the promotion piece
+    std::optional<Move::Move> unpack_move(uint16_t packed, Move::Color color);
+};
+
+#endif
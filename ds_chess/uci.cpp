@@ -1,37 +1,90 @@
 //
 // Created by river on 5/13/24.
 //
+#include <algorithm>
 #include <iostream>
 #include <optional>
+#include <stdexcept>
 
 #include "uci.h"
+#include "bench.h"
+#include "bitbase.h"
 #include "board.h"
+#include "epd.h"
+#include "pgn.h"
 #include "search.h"
+#include "stats.h"
+#include "time_manager.h"
 #include "string_handling.h"
+#include "syzygy.h"
+#include "syzygy_check.h"
+#include "trace.h"
 
 void UCI::uci_loop() {
     std::optional<Board::Board> board;
+    PositionHistory position_history = PositionHistory();
+    Options options = Options();
+    TranspositionTable::TranspositionTable transposition_table = TranspositionTable::TranspositionTable(
+        TranspositionTable::DEFAULT_SIZE_MB
+    );
+    Book::Book book = Book::Book();
 
+    SearchThread search_thread = SearchThread();
+    //the bitbases are generated while the gui sets up, endgames are evaluated without them until they're done
+    std::thread bitbase_thread = std::thread(Bitbase::init, BITBASE_THREADS);
+
+    //reused for every line, so reading a command doesn't allocate once the longest line has been seen
+    std::string input;
     while (true) {
-        std::string input;
-        getline(std::cin, input);
-        std::vector<std::string> args = StringHandling::split(input, ' ');
+        if (!getline(std::cin, input)) {
+            //the gui went away
+            input = "quit";
+        }
+        StringHandling::Tokenizer tokens = StringHandling::Tokenizer(input);
+        std::string_view command = tokens.next();
 
-        if (args.empty()) {
+        if (command.empty()) {
             continue;
         }
 
-        if (args[0] == "uci") {
+        if (command == "uci") {
             UCI::uci_command();
-        } else if (args[0] == "isready") {
+        } else if (command == "isready") {
             UCI::isready_command();
-        } else if (args[0] == "position") {
-            UCI::position_command(args.begin() + 1, args.end(), &board);
-        } else if (args[0] == "go") {
-            UCI::go_command(args.begin() + 1, args.end(), &board);
-        } else if (args[0] == "print") {
+        } else if (command == "ucinewgame") {
+            //the transposition table belongs to the search while it runs
+            UCI::stop_command(&search_thread);
+            UCI::ucinewgame_command(&transposition_table);
+        } else if (command == "setoption") {
+            UCI::stop_command(&search_thread);
+            UCI::setoption_command(&tokens, &options, &transposition_table, &book);
+        } else if (command == "position") {
+            UCI::position_command(&tokens, &board, &position_history);
+        } else if (command == "go") {
+            UCI::go_command(&tokens, &board, &options, &transposition_table, &book, &search_thread);
+        } else if (command == "stop") {
+            UCI::stop_command(&search_thread);
+        } else if (command == "ponderhit") {
+            UCI::ponderhit_command(&search_thread);
+        } else if (command == "bench") {
+            UCI::stop_command(&search_thread);
+            Bench::bench(tokens.has_next() ? StringHandling::to_int(tokens.next()) : Bench::DEFAULT_DEPTH);
+        } else if (command == "epd") {
+            UCI::stop_command(&search_thread);
+            EPD::epd_command(&tokens);
+        } else if (command == "analyse-pgn") {
+            UCI::stop_command(&search_thread);
+            PGN::analyse_command(&tokens);
+        } else if (command == "stats") {
+            UCI::stats_command();
+        } else if (command == "print") {
             UCI::print_command(&board);
-        } else if (args[0] == "quit") {
+        } else if (command == "quit") {
+            UCI::stop_command(&search_thread);
+            Trace::close();
+            //the bitbases wouldn't be used any more, so quitting doesn't wait for them to finish
+            Bitbase::cancel();
+            bitbase_thread.join();
             break;
         } else {
             std::cout << "invalid command" << std::endl;
@@ -41,74 +94,318 @@ void UCI::uci_loop() {
 
 void UCI::uci_command() {
     std::cout << "id name " << NAME << "\n";
-    std::cout << "id author " << AUTHOR << std::endl;
+    std::cout << "id author " << AUTHOR << "\n";
+    std::cout << "option name Hash type spin default " << TranspositionTable::DEFAULT_SIZE_MB
+        << " min " << TranspositionTable::MIN_SIZE_MB
+        << " max " << TranspositionTable::MAX_SIZE_MB << "\n";
+    std::cout << "option name MultiPV type spin default " << DEFAULT_MULTI_PV
+        << " min 1 max " << MAX_MULTI_PV << "\n";
+    std::cout << "option name Ponder type check default false\n";
+    std::cout << "option name OwnBook type check default false\n";
+    std::cout << "option name BookFile type string default <empty>\n";
+    std::cout << "option name SyzygyPath type string default <empty>\n";
+    std::cout << "option name SyzygyProbeDepth type spin default " << DEFAULT_SYZYGY_PROBE_DEPTH
+        << " min 1 max " << MAX_SYZYGY_PROBE_DEPTH << "\n";
+    std::cout << "option name TraceFile type string default <empty>\n";
+    std::cout << "uciok" << std::endl;
 }
 
 void UCI::isready_command() {
     std::cout << "readyok" << std::endl;
 }
 
-void UCI::position_command(
-    std::vector<std::string>::iterator begin,
-    std::vector<std::string>::iterator end,
-    std::optional<Board::Board> *board
+void UCI::ucinewgame_command(TranspositionTable::TranspositionTable *transposition_table) {
+    transposition_table->clear();
+}
+
+void UCI::setoption_command(
+    StringHandling::Tokenizer *tokens,
+    Options *options,
+    TranspositionTable::TranspositionTable *transposition_table,
+    Book::Book *book
 ) {
-    auto index = begin;
-
-    if (*index == "startpos") {
-        *board = Board::Board(STARTPOS);
-        index += 1;
-    } else if (*index == "fen") {
-        std::string fen = index[1] + " " + index[2] + " " + index[3] + " " + index[4] + " " + index[5] + " " + index[6];
-        *board = Board::Board(fen);
-        index += 6;
-    } else {
+    //setoption name <id> [value <x>], where both the id and the value may contain spaces
+    if (tokens->next() != "name" || !tokens->has_next()) {
+        std::cout << "invalid command" << std::endl;
         return;
     }
+    std::string_view first = tokens->next();
+    std::string_view last = first;
+    while (tokens->has_next() && tokens->peek() != "value") {
+        last = tokens->next();
+    }
+    std::string_view name = StringHandling::span(first, last);
+    std::optional<std::string_view> value = std::nullopt;
+    if (tokens->next() == "value") {
+        value = tokens->rest();
+    }
+
+    if (name == "Hash" && value.has_value()) {
+        transposition_table->resize(std::clamp<int64_t>(
+            StringHandling::to_int(value.value()),
+            TranspositionTable::MIN_SIZE_MB,
+            TranspositionTable::MAX_SIZE_MB
+        ));
+    } else if (name == "MultiPV" && value.has_value()) {
+        options->multi_pv = std::clamp<int64_t>(StringHandling::to_int(value.value()), 1, MAX_MULTI_PV);
+    } else if (name == "TraceFile") {
+        //chrome trace event json of every following search, <empty> turns tracing off
+        if (value.has_value() && value.value() != "<empty>") {
+            Trace::open(std::string(value.value()));
+            Trace::name_thread("uci");
+        } else {
+            Trace::close();
+        }
+    } else if (name == "OwnBook" && value.has_value()) {
+        options->own_book = value.value() == "true";
+    } else if (name == "BookFile") {
+        //polyglot book, mapped rather than read so opening even a large one is instant
+        if (value.has_value() && value.value() != "<empty>") {
+            if (!book->open(std::string(value.value()))) {
+                std::cout << "info string could not open book " << value.value() << std::endl;
+            }
+        } else {
+            book->close();
+        }
+    } else if (name == "SyzygyPath") {
+        //the files are only mapped once a position needs them
+        size_t found = Syzygy::init(value.has_value() ? std::string(value.value()) : "");
+        std::cout << "info string found " << found << " tablebases" << std::endl;
+        //a table that decodes wrongly would have the search play a lost move as a won one, so none are used
+        //unless the small ones agree with their own moves
+        SyzygyCheck::Result check = SyzygyCheck::check_wdl(
+            SyzygyCheck::LOAD_CHECK_MAX_PIECES, SyzygyCheck::LOAD_CHECK_SAMPLES, found
+        );
+        if (check.mismatches > 0) {
+            Syzygy::init("");
+            std::cout << "info string tablebases failed " << check.mismatches << " of " << check.positions
+                << " checks and are not used" << std::endl;
+        } else if (!SyzygyCheck::checked_every_table(&check)) {
+            //a table no position could be compared for is one whose file can't be read
+            Syzygy::init("");
+            std::cout << "info string tablebases could not be read and are not used" << std::endl;
+        }
+    } else if (name == "SyzygyProbeDepth" && value.has_value()) {
+        options->syzygy_probe_depth = std::clamp<int64_t>(
+            StringHandling::to_int(value.value()), 1, MAX_SYZYGY_PROBE_DEPTH
+        );
+    } else if (name == "Ponder" && value.has_value()) {
+        options->ponder = value.value() == "true";
+    } else {
+        std::cout << "unknown option " << name << std::endl;
+    }
+}
 
-    if (index >= end || *index != "moves") {
+void UCI::position_command(
+    StringHandling::Tokenizer *tokens,
+    std::optional<Board::Board> *board,
+    PositionHistory *history
+) {
+    std::string_view base = tokens->next();
+    if (base == "fen" && tokens->has_next()) {
+        //the fields of the fen, up to the move list
+        std::string_view first = tokens->next();
+        std::string_view last = first;
+        while (tokens->has_next() && tokens->peek() != "moves") {
+            last = tokens->next();
+        }
+        base = StringHandling::span(first, last);
+    } else if (base != "startpos") {
         return;
     }
+    if (tokens->peek() == "moves") {
+        tokens->next();
+    }
 
-    index += 1;
-    while (index < end) {
-        auto move = Move::Move::string_to_move(*index);
-        if (board->has_value() && std::holds_alternative<Board::SuccessfulOperation>(
-            board->value().is_valid_move(&move)
-        )) {
-            board->value().make_move(&move);
-        } else {
-            std::cout << "invalid move " << move.to_string() << std::endl;
-            auto e = std::get<Board::MoveError>(board->value().is_valid_move(&move));
-            std::cout << e << std::endl;
+    //guis resend the whole game every move, if it only adds moves to the current position just play those
+    bool extends_history = board->has_value() && base == history->base;
+    if (extends_history) {
+        StringHandling::Tokenizer applied = StringHandling::Tokenizer(history->moves);
+        StringHandling::Tokenizer new_moves = *tokens;
+        while (applied.has_next() && applied.peek() == new_moves.peek()) {
+            applied.next();
+            new_moves.next();
+        }
+        extends_history = !applied.has_next();
+        if (extends_history) {
+            *tokens = new_moves;
+        }
+    }
+    if (!extends_history) {
+        bool had_board = board->has_value();
+        if (!had_board) {
+            board->emplace();
+        }
+        Board::FenResult result = board->value().set_fen(base == "startpos" ? std::string_view(Board::STARTPOS) : base);
+        if (std::holds_alternative<Board::FenError>(result)) {
+            std::cout << "invalid fen " << base << std::endl;
+            std::cout << std::get<Board::FenError>(result) << std::endl;
+            if (!had_board) {
+                board->reset();
+            }
+            return;
+        }
+        history->base = base;
+        history->moves.clear();
+    }
+
+    while (tokens->has_next()) {
+        std::string_view token = tokens->next();
+        std::optional<Move::Move> move = std::nullopt;
+        try {
+            move = Move::Move::string_to_move(token);
+        } catch (std::invalid_argument &e) {
+            std::cout << "invalid move " << token << std::endl;
+            return;
+        }
+        Board::MoveResult result = board->value().is_valid_move(&move.value());
+        if (!std::holds_alternative<Board::SuccessfulOperation>(result)) {
+            std::cout << "invalid move " << token << std::endl;
+            std::cout << std::get<Board::MoveError>(result) << std::endl;
             return;
         }
-        index += 1;
+        board->value().make_move(&move.value());
+        if (!history->moves.empty()) {
+            history->moves += ' ';
+        }
+        history->moves += token;
     }
 }
 
 void UCI::go_command(
-    std::vector<std::string>::iterator begin,
-    std::vector<std::string>::iterator end,
-    std::optional<Board::Board> *board
+    StringHandling::Tokenizer *tokens,
+    std::optional<Board::Board> *board,
+    Options *options,
+    TranspositionTable::TranspositionTable *transposition_table,
+    Book::Book *book,
+    SearchThread *search_thread
 ) {
-    auto index = begin;
+    if (!board->has_value()) {
+        std::cout << "no board stored" << std::endl;
+        return;
+    }
+    //only one search at a time
+    UCI::stop_command(search_thread);
 
-    int32_t depth = 4;
+    Search::SearchLimits limits = Search::SearchLimits();
+    limits.multi_pv = options->multi_pv;
+    limits.syzygy_probe_depth = options->syzygy_probe_depth;
+    std::optional<int32_t> depth = std::nullopt;
+    Move::Color player = board->value().current_player;
+    TimeManager::TimeControl time_control = TimeManager::TimeControl();
 
-    while (index < end) {
-        if (*index == "depth") {
-            index += 1;
-            depth = atoi(index->c_str());
+    while (tokens->has_next()) {
+        std::string_view token = tokens->next();
+        if (token == "depth") {
+            depth = StringHandling::to_int(tokens->next());
+        } else if (
+            (token == "wtime" && player == Move::Color::White)
+            || (token == "btime" && player == Move::Color::Black)
+        ) {
+            time_control.time_left = StringHandling::to_int(tokens->next());
+        } else if (
+            (token == "winc" && player == Move::Color::White)
+            || (token == "binc" && player == Move::Color::Black)
+        ) {
+            time_control.increment = StringHandling::to_int(tokens->next());
+        } else if (token == "movestogo") {
+            time_control.moves_to_go = StringHandling::to_int(tokens->next());
+        } else if (token == "movetime") {
+            time_control.move_time = StringHandling::to_int(tokens->next());
+        } else if (token == "nodes") {
+            limits.nodes = std::max<int64_t>(0, StringHandling::to_int(tokens->next()));
+        } else if (token == "mate") {
+            limits.mate = std::max<int64_t>(1, StringHandling::to_int(tokens->next()));
+        } else if (token == "infinite") {
+            time_control.infinite = true;
+        } else if (token == "ponder") {
+            time_control.ponder = true;
+        } else if (token == "searchmoves") {
+            //every following token that reads as a move
+            while (tokens->has_next()) {
+                try {
+                    limits.search_moves.push_back(Move::Move::string_to_move(tokens->peek()));
+                } catch (std::invalid_argument &e) {
+                    break;
+                }
+                tokens->next();
+            }
         } //check for other go paramters
-        index += 1;
     }
-    Search::init_search(depth, &board->value());
+
+    //a book move is played straight away, unless the gui wants the search to run until it says stop
+    if (options->own_book && !time_control.infinite && !time_control.ponder && limits.search_moves.empty()) {
+        std::optional<Move::Move> book_move = book->probe(&board->value());
+        if (book_move.has_value()) {
+            std::cout << "bestmove " << book_move.value().to_string() << std::endl;
+            return;
+        }
+    }
+
+    search_thread->time_manager = std::make_unique<TimeManager::TimeManager>(time_control);
+    if (depth.has_value()) {
+        limits.depth = depth.value();
+    } else if (search_thread->time_manager->is_timed() || time_control.infinite || time_control.ponder) {
+        limits.depth = Search::MAX_PLY;
+    } else if (limits.mate.has_value()) {
+        limits.depth = std::min(Search::MAX_PLY, 2 * limits.mate.value() - 1);
+    } else if (!limits.nodes.has_value()) {
+        limits.depth = DEFAULT_DEPTH;
+    }
+
+    //the search gets its own copy of the board, the loop may be given a new position meanwhile
+    search_thread->thread = std::thread(
+        [
+            limits,
+            position = board->value(),
+            time_manager = search_thread->time_manager.get(),
+            transposition_table,
+            pawn_table = &search_thread->pawn_table,
+            material_table = &search_thread->material_table
+        ]() mutable {
+            Trace::name_thread("search");
+            {
+                Trace::Scope search_scope = Trace::Scope("search", "thread");
+                Search::init_search(&limits, &position, time_manager, transposition_table, pawn_table, material_table);
+            }
+            Trace::flush();
+        }
+    );
+}
+
+void UCI::stop_command(SearchThread *search_thread) {
+    if (!search_thread->thread.joinable()) {
+        return;
+    }
+    search_thread->time_manager->stop();
+    search_thread->thread.join();
+}
+
+void UCI::ponderhit_command(SearchThread *search_thread) {
+    if (!search_thread->thread.joinable()) {
+        return;
+    }
+    search_thread->time_manager->ponderhit();
+}
+
+void UCI::stats_command() {
+#ifdef DS_CHESS_STATS
+    std::optional<Stats::SearchStats> stats = Stats::last_search();
+    if (!stats.has_value()) {
+        std::cout << "info string no search finished yet" << std::endl;
+        return;
+    }
+    Stats::print(&stats.value());
+#else
+    std::cout << "info string search statistics are not compiled in, build with DS_CHESS_STATS" << std::endl;
+#endif
 }
 
 void UCI::print_command(std::optional<Board::Board> *board) {
     if (board->has_value()) {
         board->value().print_board();
+        Board::FenBuffer fen = Board::FenBuffer();
+        std::cout << "fen " << board->value().to_fen(&fen) << std::endl;
     } else {
         std::cout << "no board stored" << std::endl;
     }
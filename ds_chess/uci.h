@@ -1,32 +1,89 @@
 #ifndef UCI_H
 #define UCI_H
 
+#include<memory>
 #include<optional>
 #include<string>
-#include<vector>
+#include<thread>
 
 #include "board.h"
+#include "book.h"
+#include "material_table.h"
+#include "pawn_table.h"
+#include "string_handling.h"
+#include "time_manager.h"
+#include "transposition_table.h"
 
 namespace UCI {
     const std::string NAME = "ds_chess";
     const std::string AUTHOR = "Justin and Cora";
-    //Forsyth Edwards notation for position:
-    // pieces, player to move, castling rights, en passant, 50 move rule, total ply
-    const std::string STARTPOS = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    //depth searched by a go command without a depth or any time control
+    const int32_t DEFAULT_DEPTH = 4;
+    const size_t DEFAULT_MULTI_PV = 1;
+    const size_t MAX_MULTI_PV = 256;
+    const int32_t DEFAULT_SYZYGY_PROBE_DEPTH = 1;
+    const int32_t MAX_SYZYGY_PROBE_DEPTH = 100;
+    //the bitbases are generated in the background alongside the search, so they take one core rather than every one
+    const size_t BITBASE_THREADS = 1;
+
+    //engine settings changed through setoption
+    struct Options {
+        size_t multi_pv = DEFAULT_MULTI_PV;
+        //only tells the engine that the gui may send go ponder, which is always supported
+        bool ponder = false;
+        //play moves from the BookFile book while it has any, without searching
+        bool own_book = false;
+        //tablebases are only probed with at least this much depth left
+        int32_t syzygy_probe_depth = DEFAULT_SYZYGY_PROBE_DEPTH;
+    };
+
+    //the search runs on its own thread so that the loop can still answer isready and stop
+    struct SearchThread {
+        std::thread thread;
+        std::unique_ptr<TimeManager::TimeManager> time_manager;
+        //kept from one search to the next, only the search running on thread uses them
+        PawnTable::PawnTable pawn_table = PawnTable::PawnTable(PawnTable::DEFAULT_SIZE);
+        MaterialTable::MaterialTable material_table = MaterialTable::MaterialTable(MaterialTable::DEFAULT_SIZE);
+    };
+
+    //how the current board was set up by the last position command
+    struct PositionHistory {
+        //"startpos" or a fen
+        std::string base;
+        //the moves played from base, separated by single spaces
+        std::string moves;
+    };
 
     void uci_loop();
     void uci_command();
     void isready_command();
+    void ucinewgame_command(TranspositionTable::TranspositionTable *transposition_table);
+    void setoption_command(
+        StringHandling::Tokenizer *tokens,
+        Options *options,
+        TranspositionTable::TranspositionTable *transposition_table,
+        Book::Book *book
+    );
+    //sets up the board, only playing the new moves when the move list continues the previous position's
     void position_command(
-        std::vector<std::string>::iterator begin,
-        std::vector<std::string>::iterator end,
-        std::optional<Board::Board> *board
+        StringHandling::Tokenizer *tokens,
+        std::optional<Board::Board> *board,
+        PositionHistory *history
     );
     void go_command(
-        std::vector<std::string>::iterator begin,
-        std::vector<std::string>::iterator end,
-        std::optional<Board::Board> *board
-    );;
+        StringHandling::Tokenizer *tokens,
+        std::optional<Board::Board> *board,
+        Options *options,
+        TranspositionTable::TranspositionTable *transposition_table,
+        Book::Book *book,
+        SearchThread *search_thread
+    );
+    //stops the running search, if any, and waits for it to send its best move
+    void stop_command(SearchThread *search_thread);
+    //the opponent played the ponder move, the running ponder search continues on our clock
+    void ponderhit_command(SearchThread *search_thread);
+    //counters of the last finished search, when built with DS_CHESS_STATS
+    void stats_command();
     void print_command(std::optional<Board::Board> *board);
 };
 
@@ -0,0 +1,101 @@
+#include "zobrist.h"
+
+#include <array>
+
+namespace Zobrist {
+    struct Keys {
+        std::array<uint64_t, 2 * 6 * 64> pieces;
+        std::array<uint64_t, 16> castling;
+        std::array<uint64_t, 8> en_passant;
+        uint64_t side;
+    };
+
+    //splitmix64, so the keys (and so every hash) are the same on every build
+    constexpr uint64_t next_random(uint64_t *state) {
+        *state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = *state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    constexpr Keys generate_keys() {
+        Keys keys = {};
+        uint64_t state = 0x64735F6368657373ULL;
+        for (uint64_t &key : keys.pieces) {
+            key = next_random(&state);
+        }
+        for (uint64_t &key : keys.castling) {
+            key = next_random(&state);
+        }
+        for (uint64_t &key : keys.en_passant) {
+            key = next_random(&state);
+        }
+        keys.side = next_random(&state);
+        return keys;
+    }
+
+    constexpr Keys KEYS = generate_keys();
+};
+
+uint64_t Zobrist::piece_key(Move::Piece piece, Move::Index index) {
+    return KEYS.pieces[(piece.color * 6 + piece.piece_type) * 64 + index];
+}
+
+uint64_t Zobrist::side_key() {
+    return KEYS.side;
+}
+
+uint64_t Zobrist::castling_key(Board::Board *board) {
+    size_t rights = (board->can_white_kingside_castle ? 1 : 0)
+        | (board->can_white_queenside_castle ? 2 : 0)
+        | (board->can_black_kingside_castle ? 4 : 0)
+        | (board->can_black_queenside_castle ? 8 : 0);
+    return KEYS.castling[rights];
+}
+
+uint64_t Zobrist::en_passant_key(std::optional<size_t> en_passant) {
+    if (!en_passant.has_value()) {
+        return 0;
+    }
+    return KEYS.en_passant[en_passant.value() % 8];
+}
+
+uint64_t Zobrist::compute_key(Board::Board *board) {
+    uint64_t key = 0;
+    for (Move::Index i = 0; i < std::size(board->board); i++) {
+        if (board->board[i].has_value()) {
+            key ^= piece_key(board->board[i].value(), i);
+        }
+    }
+    key ^= castling_key(board);
+    key ^= en_passant_key(board->en_passant);
+    if (board->current_player == Move::Color::Black) {
+        key ^= side_key();
+    }
+    return key;
+}
+
+uint64_t Zobrist::compute_pawn_key(Board::Board *board) {
+    uint64_t key = 0;
+    for (Move::Index i = 0; i < std::size(board->board); i++) {
+        if (board->board[i].has_value() && board->board[i].value().piece_type == Move::PieceType::Pawn) {
+            key ^= piece_key(board->board[i].value(), i);
+        }
+    }
+    return key;
+}
+
+uint64_t Zobrist::material_key_unit(Move::Piece piece) {
+    return 1ULL << (4 * (piece.color * 6 + piece.piece_type));
+}
+
+uint64_t Zobrist::compute_material_key(Board::Board *board) {
+    uint64_t key = 0;
+    for (Move::Index i = 0; i < std::size(board->board); i++) {
+        if (board->board[i].has_value()) {
+            key += material_key_unit(board->board[i].value());
+        }
+    }
+    return key;
+}
@@ -0,0 +1,25 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+#include "board.h"
+#include "move.h"
+
+namespace Zobrist {
+    uint64_t piece_key(Move::Piece piece, Move::Index index);
+    uint64_t side_key();
+    uint64_t castling_key(Board::Board *board);
+    uint64_t en_passant_key(std::optional<size_t> en_passant);
+
+    //hashes a board from scratch, make_move keeps Board::key up to date incrementally
+    uint64_t compute_key(Board::Board *board);
+    //hashes only the pawns, as Board::pawn_key
+    uint64_t compute_pawn_key(Board::Board *board);
+    //not a zobrist hash: the number of pieces of each color and type, 4 bits each at bit
+    //4 * (color * 6 + piece_type), so a piece adds material_key_unit(piece) to Board::material_key
+    uint64_t material_key_unit(Move::Piece piece);
+    uint64_t compute_material_key(Board::Board *board);
+};
+
+#endif
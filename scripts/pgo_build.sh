@@ -0,0 +1,28 @@
+#!/bin/sh
+#profile guided build: builds an instrumented engine, trains it on bench and rebuilds with the profiles
+#  scripts/pgo_build.sh [build directory] [extra cmake arguments, e.g. -DDS_CHESS_ARCH=x86-64-v3]
+set -e
+
+SOURCE_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=${1:-"$SOURCE_DIR/build-pgo"}
+[ $# -gt 0 ] && shift
+PGO_DIR="$BUILD_DIR/pgo"
+#the training run only needs to visit the hot paths, not to be deep
+BENCH_DEPTH=${BENCH_DEPTH:-5}
+
+rm -rf "$PGO_DIR"
+mkdir -p "$PGO_DIR"
+
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release \
+    -DDS_CHESS_PGO=GENERATE -DDS_CHESS_PGO_DIR="$PGO_DIR" "$@"
+cmake --build "$BUILD_DIR" --target ds_chess --clean-first
+"$BUILD_DIR/ds_chess" bench "$BENCH_DEPTH" > /dev/null
+
+#clang writes raw profiles that have to be merged, gcc uses its .gcda files as they are
+if ls "$PGO_DIR"/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -output="$PGO_DIR/ds_chess.profdata" "$PGO_DIR"/*.profraw
+fi
+
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" -DDS_CHESS_PGO=USE "$@"
+cmake --build "$BUILD_DIR" --target ds_chess --clean-first
+"$BUILD_DIR/ds_chess" bench "$BENCH_DEPTH" | tail -n 3
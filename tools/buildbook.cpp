@@ -0,0 +1,241 @@
+//builds a polyglot book from a pgn database
+//  ds_chess_buildbook <games.pgn> <book.bin> [ply <n>] [min-games <n>] [memory <mb>]
+//positions are sorted outside of memory: whenever the buffer is full it is sorted, merged and written to a
+//temporary run file, and the runs are merged into the book at the end, so only the buffer has to fit in ram
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "book.h"
+#include "pgn.h"
+#include "string_handling.h"
+
+//positions further into the game than this aren't added
+const int64_t DEFAULT_PLY = 16;
+//moves played in fewer games are left out
+const int64_t DEFAULT_MIN_GAMES = 1;
+const int64_t DEFAULT_MEMORY_MB = 256;
+//records read from each run at a time while merging
+const size_t MERGE_BLOCK = 4096;
+
+//one move played from one position, and how the games went for the player making it
+struct Record {
+    uint64_t key;
+    uint16_t move;
+    uint32_t wins;
+    uint32_t draws;
+    uint32_t losses;
+
+    bool operator<(const Record &other) const {
+        return this->key < other.key || (this->key == other.key && this->move < other.move);
+    }
+};
+
+//sorts the buffer, adds up records of the same move and writes them to a new temporary file
+static std::FILE *write_run(std::vector<Record> *records) {
+    std::sort(records->begin(), records->end());
+    size_t merged = 0;
+    for (size_t i = 0; i < records->size(); i++) {
+        Record *record = &(*records)[i];
+        if (merged > 0 && (*records)[merged - 1].key == record->key && (*records)[merged - 1].move == record->move) {
+            (*records)[merged - 1].wins += record->wins;
+            (*records)[merged - 1].draws += record->draws;
+            (*records)[merged - 1].losses += record->losses;
+        } else {
+            (*records)[merged++] = *record;
+        }
+    }
+
+    std::FILE *run = std::tmpfile();
+    if (run == nullptr || std::fwrite(records->data(), sizeof(Record), merged, run) != merged) {
+        std::cerr << "could not write a temporary file" << std::endl;
+        std::exit(1);
+    }
+    std::rewind(run);
+    records->clear();
+    return run;
+}
+
+//reads a run back a block at a time
+struct RunReader {
+    std::FILE *file;
+    std::vector<Record> block;
+    size_t next;
+
+    bool has_next() {
+        if (this->next == this->block.size()) {
+            this->block.resize(MERGE_BLOCK);
+            this->block.resize(std::fread(this->block.data(), sizeof(Record), MERGE_BLOCK, this->file));
+            this->next = 0;
+        }
+        return !this->block.empty();
+    }
+};
+
+//writes the moves of one position, the best first, with the weights scaled down to fit in 16 bits if needed
+static size_t write_position(std::vector<Record> *moves, int64_t min_games, std::ofstream *out) {
+    std::vector<Book::Entry> entries = std::vector<Book::Entry>();
+    uint64_t max_weight = 0;
+    for (Record &record : *moves) {
+        if (record.wins + record.draws + record.losses < min_games) {
+            continue;
+        }
+        //polyglot's weighting: a win is worth two draws, a loss nothing
+        uint64_t weight = 2 * (uint64_t) record.wins + record.draws;
+        if (weight == 0) {
+            continue;
+        }
+        max_weight = std::max(max_weight, weight);
+        entries.push_back(Book::Entry {record.key, record.move, 0, 0});
+        entries.back().learn = (uint32_t) std::min<uint64_t>(weight, UINT32_MAX);
+    }
+    for (Book::Entry &entry : entries) {
+        uint64_t weight = entry.learn;
+        entry.weight = (uint16_t) std::max<uint64_t>(1, max_weight > UINT16_MAX ? weight * UINT16_MAX / max_weight : weight);
+        entry.learn = 0;
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Book::Entry &a, const Book::Entry &b) {
+        return a.weight > b.weight;
+    });
+
+    uint8_t bytes[Book::ENTRY_SIZE];
+    for (Book::Entry &entry : entries) {
+        Book::write_entry(&entry, bytes);
+        out->write((const char *) bytes, Book::ENTRY_SIZE);
+    }
+    moves->clear();
+    return entries.size();
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: ds_chess_buildbook <games.pgn> <book.bin> [ply <n>] [min-games <n>] [memory <mb>]" << std::endl;
+        return 1;
+    }
+    std::string arguments = std::string();
+    for (int i = 3; i < argc; i++) {
+        arguments += std::string(argv[i]) + " ";
+    }
+    int64_t max_ply = DEFAULT_PLY;
+    int64_t min_games = DEFAULT_MIN_GAMES;
+    int64_t memory_mb = DEFAULT_MEMORY_MB;
+    StringHandling::Tokenizer tokens = StringHandling::Tokenizer(arguments);
+    while (tokens.has_next()) {
+        std::string_view token = tokens.next();
+        if (token == "ply") {
+            max_ply = std::max<int64_t>(1, StringHandling::to_int(tokens.next()));
+        } else if (token == "min-games") {
+            min_games = std::max<int64_t>(1, StringHandling::to_int(tokens.next()));
+        } else if (token == "memory") {
+            memory_mb = std::max<int64_t>(1, StringHandling::to_int(tokens.next()));
+        }
+    }
+
+    std::ifstream input = std::ifstream(argv[1]);
+    if (!input.is_open()) {
+        std::cerr << "could not open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    size_t buffer_size = memory_mb * 1024 * 1024 / sizeof(Record);
+    std::vector<Record> records = std::vector<Record>();
+    records.reserve(buffer_size);
+    std::vector<std::FILE *> runs = std::vector<std::FILE *>();
+    uint64_t games = 0;
+    uint64_t positions = 0;
+
+    PGN::Reader reader = PGN::Reader(&input);
+    PGN::Game game;
+    while (reader.next_game(&game)) {
+        //unfinished games say nothing about the moves
+        if (game.result != "1-0" && game.result != "0-1" && game.result != "1/2-1/2") {
+            continue;
+        }
+        Board::Board board = Board::Board();
+        if (std::holds_alternative<Board::FenError>(board.set_fen(game.start_fen))) {
+            continue;
+        }
+        games += 1;
+        for (size_t ply = 0; ply < game.moves.size() && ply < (size_t) max_ply; ply++) {
+            Move::Move move = game.moves[ply];
+            bool white = board.current_player == Move::Color::White;
+            Record record = Record {Book::polyglot_key(&board), Book::encode_move(&board, &move), 0, 0, 0};
+            if (game.result == "1/2-1/2") {
+                record.draws = 1;
+            } else if ((game.result == "1-0") == white) {
+                record.wins = 1;
+            } else {
+                record.losses = 1;
+            }
+            records.push_back(record);
+            positions += 1;
+            if (records.size() == buffer_size) {
+                runs.push_back(write_run(&records));
+            }
+            board.make_move(&move);
+        }
+    }
+    if (!records.empty()) {
+        runs.push_back(write_run(&records));
+    }
+    records.shrink_to_fit();
+
+    std::ofstream out = std::ofstream(argv[2], std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "could not create " << argv[2] << std::endl;
+        return 1;
+    }
+
+    //k-way merge of the runs, the records of one position arrive together and in order
+    std::vector<RunReader> readers = std::vector<RunReader>();
+    for (std::FILE *run : runs) {
+        readers.push_back(RunReader {run, std::vector<Record>(), 0});
+    }
+    auto later = [&readers](size_t a, size_t b) {
+        return readers[b].block[readers[b].next] < readers[a].block[readers[a].next];
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap = std::priority_queue<size_t, std::vector<size_t>, decltype(later)>(later);
+    for (size_t i = 0; i < readers.size(); i++) {
+        if (readers[i].has_next()) {
+            heap.push(i);
+        }
+    }
+
+    std::vector<Record> position = std::vector<Record>();
+    size_t entries = 0;
+    while (!heap.empty()) {
+        size_t i = heap.top();
+        heap.pop();
+        Record record = readers[i].block[readers[i].next++];
+        if (readers[i].has_next()) {
+            heap.push(i);
+        }
+
+        if (!position.empty() && position.back().key != record.key) {
+            entries += write_position(&position, min_games, &out);
+        }
+        if (!position.empty() && position.back().move == record.move) {
+            position.back().wins += record.wins;
+            position.back().draws += record.draws;
+            position.back().losses += record.losses;
+        } else {
+            position.push_back(record);
+        }
+    }
+    entries += write_position(&position, min_games, &out);
+    for (std::FILE *run : runs) {
+        std::fclose(run);
+    }
+
+    std::cout << "games " << games
+        << " positions " << positions
+        << " runs " << runs.size()
+        << " entries " << entries << std::endl;
+    return 0;
+}